@@ -0,0 +1,42 @@
+/*================================================================================*/
+/* Header file for the arena class (bump allocator with the whole-arena reset).   */
+/*================================================================================*/
+#ifndef ARENA_H_
+#define ARENA_H_
+
+#include <stddef.h>
+#include <utils.h>
+
+/* Single memory block of the arena */
+struct Arena_block {
+    u8 *memory; /* Memory of the block */
+    size_t size; /* Size of the block (in bytes) */
+};
+typedef struct Arena_block Arena_block_t;
+
+/* Structure of the arena. Memory is taken from the blocks one after another, the blocks are never
+   freed till the arena deleting, so the reset only rewinds the current block */
+struct Arena {
+    Arena_block_t *blocks; /* Array of the allocated blocks */
+    u32 blocks_num; /* Number of the allocated blocks */
+    u32 blocks_capacity; /* Capacity of the blocks array */
+    u32 current; /* Index of the block used for the allocations */
+    size_t used; /* Number of the used bytes of the current block */
+    size_t block_size; /* Default size of the new blocks (in bytes) */
+};
+typedef struct Arena Arena_t;
+
+/* Methods of arena class */
+/* Method for creation of the empty arena with the given size of the blocks (malloc) */
+Arena_t* arena_create(const size_t block_size);
+
+/* Method for deleting the arena with all its blocks (free) */
+void arena_delete(Arena_t *arena);
+
+/* Method to allocate the memory of the size with the alignment (power of 2, up to 64 bytes) */
+void* arena_alloc(Arena_t *arena, const size_t size, const size_t alignment);
+
+/* Method to release all the allocations at once (the blocks are kept for the reuse) */
+void arena_reset(Arena_t *arena);
+
+#endif // ARENA_H_
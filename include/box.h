@@ -7,19 +7,59 @@
 
 #include <utils.h>
 #include <software_rendering.h>
+#include <float.h>
 #include <world.h>
 #include <circle.h>
-#include <circles_list.h>
-
-/* Structure of the single block if the box */
-struct Box_block {
-    V2_u32_t BL; /* Coordinates of the block bottom-left point */
-    V2_u32_t UR; /* Coordinates of the block up-right point */
-    u32 width; /* Width of the block in pix */
-    u32 height; /* Height of the block in pix */
-    Circles_list_t *circles_list; /* Pointer to the corresponding circles list */    
+#include <arena.h>
+#include <contact_engine.h>
+#include <quadtree.h>
+
+/* Cost of the infeasible circle center. The cost of the feasible center grows with the box size,
+   so no real cost can reach the largest finite f32 */
+#define BOX_INFEASIBLE_COST FLT_MAX
+
+/* Side of the square tile of the clearance raster (in pix, power of two). Pixels of the tile are
+   allocated by the first circle near it, so the memory follows the filled part of the box */
+#define BOX_TILE_SIDE 64
+
+/* Largest number of the clearance tiles of the box (the tile arrays take up to 1.2 GB). The tiles
+   are indexed by u32, and the blocks of the grid cells (at least 3 * BOX_CELL_BLOCK_SIDE pix wide)
+   are then fewer than 2^27 */
+#define BOX_MAX_TILES_NUM (1u << 26)
+
+/* Side of the square block of the grid cells allocated together (in cells) */
+#define BOX_CELL_BLOCK_SIDE 16
+
+/* Slot of the saturated tile (not in the list of the open tiles) */
+#define BOX_TILE_CLOSED 0xffffffffu
+
+/* Bits of the fraction of the circles coordinates in the sub-pixel mode (1/256 pix). Coordinates
+   of the box in the geometry units should stay below 2^30 (see overlap.h) */
+#define BOX_SUBPIXEL_BITS 8
+
+/* Width of the skyline column (in pix) */
+#define BOX_SKYLINE_COLUMN 8
+
+/* Spatial index backend of the packed circles */
+enum Box_index {
+    BOX_INDEX_GRID, /* Uniform grid with the cell larger than the largest circle diameter */
+    BOX_INDEX_QUADTREE /* Loose quadtree (for the wide distributions of the radiuses) */
+};
+typedef enum Box_index Box_index_t;
+
+/* Callback of the box query for every found record. Returns true to stop the query */
+typedef Quadtree_visit_fn_t Box_visit_fn_t;
+
+/* Structure of the single cell of the box grid */
+struct Box_cell {
+    Circle_record_t *records; /* Growable array of the records of the circles centered in the cell */
+    s32 *xs; /* Lane of the x coordinates of the records (for the overlap kernels, padded) */
+    s32 *ys; /* Lane of the y coordinates of the records */
+    s32 *rs; /* Lane of the radiuses of the records */
+    u32 records_num; /* Number of the records in the cell */
+    u32 records_capacity; /* Capacity of the records array and the lanes (multiple of 8) */
 };
-typedef struct Box_block Box_block_t;
+typedef struct Box_cell Box_cell_t;
 
 /* Structure of the box class */
 struct Box {
@@ -38,28 +78,117 @@ struct Box {
     u32 wall_width; /* Width of the box wall */
     u32 wall_clr; /* Color of the box wall */
     u32 interior_clr; /* Color of the box interior */
-    Circles_list_t *circles_list; /* List of the all packed circles (need to delete them) */
+    u32 subpixel_bits; /* Bits of the fraction of the geometry units (0 - the circles are in pix) */
+    Arena_t *arena; /* Memory of the packed circles and the grid records (released by the reset) */
+    Circle_t **circles; /* Array of the packed circles in the packing order (allocated in the arena) */
+    u32 circles_capacity; /* Capacity of the circles array */
     u32 packed_circles_num; /* Number of already packed circles */
     f32 occupied_fraction; /* Occupied area fraction of the box */
-    u32 blocks_side_num; /* Number of blocks along one side of the box_blocks */
-    Box_block_t **blocks; /* Pointer to the array of box blocks */
+    u64 radiuses_sq_sum; /* Sum of the squared radiuses of the packed circles (their area / pi) */
+    Box_index_t index_type; /* Backend of the spatial index of the packed circles */
+    Quadtree_t *quadtree; /* Quadtree of the packed circles (BOX_INDEX_QUADTREE only) */
+    u32 cell_side; /* Side of the grid cell in pix (larger than the largest circles diameter) */
+    u32 cells_x_num; /* Number of the grid cells along x */
+    u32 cells_y_num; /* Number of the grid cells along y */
+    Box_cell_t **cell_blocks; /* Blocks of the grid cells (row-major, NULL - no circles in the block) */
+    u32 cell_blocks_x_num; /* Number of the blocks of the grid cells along x */
+    u32 cell_blocks_y_num; /* Number of the blocks of the grid cells along y */
+    Contact_engine_t *contact_engine; /* Candidates of the contact placement (NULL - not used) */
+    u32 max_radius; /* Largest radius of the circles (cap of the clearance values) */
+    u16 **clearance; /* Largest insertable radius for every center pixel of the tile (row-major
+                        inside the tile, NULL - limited by the walls only or the tile is saturated) */
+    u16 *free_clearance; /* List of the released pixels of the saturated tiles (linked through them) */
+    u32 clearance_width; /* Width of the clearance raster (width_in + 1) */
+    u32 clearance_height; /* Height of the clearance raster (height_in + 1) */
+    u16 *clearance_tiles; /* Maximum clearance of every tile of the raster (row-major) */
+    u32 *clearance_counts; /* Number of the tiles with every maximum clearance 0...max_radius */
+    u32 tiles_x_num; /* Number of the clearance tiles along x */
+    u32 tiles_y_num; /* Number of the clearance tiles along y */
+    u32 min_radius; /* Smallest radius of the circles (the tile is saturated below it) */
+    u32 *open_tiles; /* Indices of the tiles which can hold the smallest circle (unordered) */
+    u32 open_tiles_num; /* Number of the open tiles (0 - the box is full) */
+    u32 *open_tile_slots; /* Index in open_tiles of every tile (BOX_TILE_CLOSED - saturated) */
+    u32 *skyline; /* Height of the fill surface above the floor for every column (0 - empty column) */
+    u32 skyline_columns_num; /* Number of the skyline columns (BOX_SKYLINE_COLUMN pix wide) */
 };
 typedef struct Box Box_t;
 
 /* Methods of box class */
-/* Method for creation of the box object (malloc) */
-Box_t *box_create(const u32 blocks_side_num);
+/* Method for creation of the box object for the circles with the radiuses min_radius...max_radius
+   with the given spatial index backend (malloc) */
+Box_t *box_create(const u32 min_radius, const u32 max_radius, const Box_index_t index_type);
 
 /* Method for deleting the box object (free) */
 void box_delete(Box_t *box);
 
-/* Initialization of the box object fields */
-void box_init(Box_t *box, World_t *world, const u32 box_width_out, const u32 box_height_out,
-              const u32 box_wall_width, const u32 text_panel_height, const u32 box_wall_clr,
-              const u32 box_interior_clr);
+/* Method to check that the box of the outer size fits the limits of its arrays (the number of the
+   clearance tiles is at most BOX_MAX_TILES_NUM) */
+b32 box_size_is_valid(const u32 box_width_out, const u32 box_height_out, const u32 box_wall_width);
+
+/* Initialization of the box object fields (the size should be valid, see box_size_is_valid) */
+void box_init(Box_t *box, const V2_u32_t BL_out, const u32 box_width_out, const u32 box_height_out,
+              const u32 box_wall_width, const u32 box_wall_clr, const u32 box_interior_clr);
+
+/* Method to set the sub-pixel mode: the circles centers are kept in 1/2^BOX_SUBPIXEL_BITS pix (the
+   geometry units). Should be set before the box initialization */
+void box_set_subpixel(Box_t *box, const b32 is_subpixel);
+
+/* Method to set the contact engine updated with the box (the box becomes its owner) */
+void box_set_contact_engine(Box_t *box, Contact_engine_t *contact_engine);
+
+/* Method for adding new circle to the box. Returns the circle object owned by the box (valid till
+   the next box initialization) */
+Circle_t* box_add_circle(Box_t *box, const V2_u32_t center, const u32 radius, const u32 color);
+
+/* Method for adding new circle with the center at the position in the geometry units */
+Circle_t* box_add_circle_at(Box_t *box, const V2_u32_t position, const u32 radius, const u32 color);
+
+/* Method to restore the circles (centers in the geometry units) in the empty initialized box with
+   the bulk build of the spatial index (the contact engine is not updated) */
+void box_restore(Box_t *box, const V2_u32_t *positions, const u32 *radiuses, const u32 *colors,
+                 const u32 circles_num);
+
+/* Method to get the range of the grid cells containing the centers within reach from (x0, y0) */
+void box_cells_range(const Box_t *box, const u32 x0, const u32 y0, const u32 reach, u32 *cx_begin,
+                     u32 *cx_end, u32 *cy_begin, u32 *cy_end);
+
+/* Method to visit the records of the circles which can intersect the square of half side reach
+   around (x0, y0) (in pix, the records are in the geometry units). Returns true if the query was
+   stopped by the callback */
+b32 box_query(const Box_t *box, const u32 x0, const u32 y0, const u32 reach, Box_visit_fn_t visit,
+              void *data);
+
+/* Method to check the circle against the packed circles of the index (without the clearance) */
+b32 box_index_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius);
+
+/* Method to check that the circle with the center at (x0, y0) does not intercept packed circles */
+b32 box_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius);
+
+/* Method to check that the circle with the center at the position in the geometry units does not
+   intercept packed circles */
+b32 box_is_feasible_at(const Box_t *box, const V2_u32_t position, const u32 radius);
+
+/* Method to move the feasible circle down and then to the middle by less than a pixel while it stays
+   feasible (sub-pixel mode only). Returns the new position in the geometry units */
+V2_u32_t box_settle(const Box_t *box, const V2_u32_t position, const u32 radius);
+
+/* Method to calculate the cost of the circle center (distance to the middle bottom point + height) */
+f32 box_center_cost(const Box_t *box, const u32 x0, const u32 y0);
+
+/* Method to calculate the cost of the circle center at the position in the geometry units */
+f32 box_position_cost(const Box_t *box, const V2_u32_t position);
+
+/* Method to calculate the feasibility flags and the costs of n circle centers of the radius in one
+   pass (centers in the geometry units, infeasible centers get BOX_INFEASIBLE_COST) */
+void box_query_batch(const Box_t *box, const u32 radius, const u32 n, const u32 *xs, const u32 *ys, f32 *costs,
+                     b32 *is_feasible);
+
+/* Method to get the lowest y of the bottom of the circle centered at the column x0 which is above
+   the skyline (such circle does not intercept the packed circles) */
+u32 box_surface_y(const Box_t *box, const u32 x0, const u32 radius);
 
-/* Method for adding new circle to the corresponding box block */
-void box_add_circle(Box_t *box, Circle_t *circle);
+/* Method to get the largest insertable radius (up to max_radius) of the circle in the whole box */
+u32 box_largest_radius(const Box_t *box);
 
 /* Method for render the box */
 void box_render(Box_t *box, Render_Buffer_t *render_buffer);
@@ -0,0 +1,26 @@
+/*================================================================================*/
+/* Header file for the checkpoint functions (binary snapshot of the packing run). */
+/*================================================================================*/
+#ifndef CHECKPOINT_H_
+#define CHECKPOINT_H_
+
+#include <utils.h>
+#include <packing.h>
+
+/* Signature of the checkpoint file ("CPCK" in the file) and the version of its format */
+#define CHECKPOINT_MAGIC 0x4b435043u
+#define CHECKPOINT_VERSION 1
+
+/* Method to save the state of the packing run (circles, radius and color classes, box geometry,
+   random numbers generators and counters) to the file. The file is written under the temporary
+   name and renamed, so the previous checkpoint is replaced only by the complete one. Returns false
+   if the file can't be written */
+b32 checkpoint_save(const Packing_t *packing, const char *file_path);
+
+/* Method to restore the state of the packing run from the file. The packing should be created with
+   the same engine, spatial index, PSO swarms and speculation number, the spatial index is built in
+   one pass over the circles. Returns false (the packing is not changed) if the file can't be read,
+   is damaged or does not match the packing */
+b32 checkpoint_load(Packing_t *packing, const char *file_path);
+
+#endif // CHECKPOINT_H_
@@ -6,15 +6,29 @@
 
 #include <utils.h>
 #include <software_rendering.h>
+#include <rng.h>
 
 /* Structure of the circle */
 struct Circle {
-    V2_u32_t center; /* Coordinates of the center */
+    V2_u32_t center; /* Coordinates of the center (in pix, rounded for the rendering) */
+    V2_u32_t position; /* Coordinates of the center in the geometry units of the box (equal to the
+                          center without the sub-pixel mode) */
     u32 radius; /* Radius of the circle */
     u32 color; /* Color of the circle */
 };
 typedef struct Circle Circle_t;
 
+/* Packed record of the circle stored in the spatial indices of the box (copied, so the scans
+   stream through the contiguous memory without dereferencing the circles). All the values are in
+   the geometry units of the box */
+struct Circle_record {
+    u32 x; /* X coordinate of the circle center */
+    u32 y; /* Y coordinate of the circle center */
+    u32 radius; /* Radius of the circle */
+    u32 index; /* Index of the circle in the packing order */
+};
+typedef struct Circle_record Circle_record_t;
+
 /* Methods of circle class */
 /* Method for creation of the circle object (malloc)*/
 Circle_t* circle_create(V2_u32_t center, u32 radius, u32 color);
@@ -32,7 +46,7 @@ void circle_render(Circle_t *circle, Render_Buffer_t *render_buffer);
 void circle_render_marker(V2_u32_t marker_center, Render_Buffer_t *render_buffer);
 
 /* Method for generation of the radius from the probability distribution */
-void circle_generate_params(const u32 circles_types, const f32 *circles_prob, const u32 *circles_col,
-                            const u32 *circles_radiuses, u32 *color, u32 *radius);
+void circle_generate_params(Rng_t *rng, const u32 circles_types, const f32 *circles_prob,
+                            const u32 *circles_col, const u32 *circles_radiuses, u32 *color, u32 *radius);
 
 #endif //CIRCLE_H
@@ -0,0 +1,59 @@
+/*================================================================================*/
+/* Header file for the contact_engine class (deterministic placement engine).     */
+/*================================================================================*/
+#ifndef CONTACT_ENGINE_H_
+#define CONTACT_ENGINE_H_
+
+#include <utils.h>
+#include <circle.h>
+
+struct Box;
+
+/* Candidate position of the circle center (touching the floor, a wall or the packed circles) */
+struct Contact_candidate {
+    V2_u32_t position; /* Coordinates (in the geometry units of the box) of the circle center */
+    f32 cost; /* Cost of the position (the same as the PSO cost) */
+};
+typedef struct Contact_candidate Contact_candidate_t;
+
+/* Candidates of the one radius class. Only the feasible (alive) candidates are kept */
+struct Contact_class {
+    u32 radius; /* Radius of the circles of the class */
+    Contact_candidate_t *candidates; /* Array of the alive candidates */
+    u32 candidates_num; /* Number of the alive candidates */
+    u32 candidates_capacity; /* Capacity of the candidates array */
+};
+typedef struct Contact_class Contact_class_t;
+
+/* Structure of the contact engine */
+struct Contact_engine {
+    u32 classes_num; /* Number of the radius classes */
+    Contact_class_t *classes; /* Array of the radius classes */
+    u32 max_radius; /* Maximum radius of all classes */
+    Circle_record_t *neighbours; /* Temporary array of the neighbours of the added circle */
+    u32 neighbours_capacity; /* Capacity of the neighbours array */
+};
+typedef struct Contact_engine Contact_engine_t;
+
+/* Methods of contact_engine class */
+/* Method for creation of the contact engine for the circles with the given radiuses (malloc) */
+Contact_engine_t* contact_engine_create(const u32 *radiuses, const u32 radiuses_num);
+
+/* Method for deleting the contact engine */
+void contact_engine_delete(Contact_engine_t *engine);
+
+/* Initialization (reset) of the engine for the empty box */
+void contact_engine_init(Contact_engine_t *engine, const struct Box *box);
+
+/* Method to update the candidates after the circle has been added to the box */
+void contact_engine_add_circle(Contact_engine_t *engine, const struct Box *box, const Circle_t *circle);
+
+/* Method to find the lowest cost position (in the geometry units) for the circle of the radius
+   (false - no place) */
+b32 contact_engine_find(const Contact_engine_t *engine, const u32 radius, V2_u32_t *position);
+
+/* Method to replace the candidates of the class by the saved ones (restore of the engine state) */
+void contact_engine_set_candidates(Contact_engine_t *engine, const u32 class_index,
+                                   const Contact_candidate_t *candidates, const u32 candidates_num);
+
+#endif // CONTACT_ENGINE_H_
@@ -0,0 +1,83 @@
+/*================================================================================*/
+/* Header file for the ensemble class (independent packing runs in parallel).     */
+/*================================================================================*/
+#ifndef ENSEMBLE_H_
+#define ENSEMBLE_H_
+
+#include <pthread.h>
+#include <utils.h>
+#include <packing.h>
+#include <thread_pool.h>
+
+/* Result of one packing run of the ensemble */
+struct Ensemble_run {
+    u32 index; /* Index of the run (0...runs_num-1) */
+    u64 seed; /* Seed of the run */
+    u32 packed_circles_num; /* Number of the packed circles */
+    f32 occupied_fraction; /* Occupied area fraction of the box */
+    u64 searches_num; /* Number of the performed searches */
+    f64 time; /* Time of the run (in seconds) */
+};
+typedef struct Ensemble_run Ensemble_run_t;
+
+/* Value of the runs for the statistics */
+enum Ensemble_value {
+    ENSEMBLE_VALUE_CIRCLES, /* Number of the packed circles */
+    ENSEMBLE_VALUE_FRACTION, /* Occupied area fraction of the box */
+    ENSEMBLE_VALUE_TIME /* Time of the run */
+};
+typedef enum Ensemble_value Ensemble_value_t;
+
+/* Statistics of the value over the runs of the ensemble */
+struct Ensemble_stats {
+    f64 mean; /* Mean value */
+    f64 variance; /* Sample variance (0.0 for one run) */
+    f64 min; /* Minimum value */
+    f64 p5; /* 5th percentile */
+    f64 p25; /* 25th percentile */
+    f64 median; /* Median (50th percentile) */
+    f64 p75; /* 75th percentile */
+    f64 p95; /* 95th percentile */
+    f64 max; /* Maximum value */
+};
+typedef struct Ensemble_stats Ensemble_stats_t;
+
+/* Function creating the initialized packing of the run with the seed (called by the worker threads,
+   so it should not modify the shared data) */
+typedef Packing_t* (*Ensemble_create_fn_t)(void *ctx, const u64 seed);
+
+/* Function reporting the finished run (called under the lock of the ensemble in the order of the
+   completion) */
+typedef void (*Ensemble_report_fn_t)(void *ctx, const Ensemble_run_t *run);
+
+/* Structure of the ensemble of the independent packing runs */
+struct Ensemble {
+    u32 runs_num; /* Number of the runs */
+    Ensemble_run_t *runs; /* Results of the runs (every run writes only its own element) */
+    u32 runs_done; /* Number of the finished runs */
+    Thread_pool_t *thread_pool; /* Pool of worker threads running the runs (NULL - single thread) */
+    pthread_mutex_t mutex; /* Mutex protecting the report of the finished runs */
+    u64 seed; /* Seed of the first run (run k uses seed + k) */
+    u32 max_circles; /* Stop every run after packing this number of circles (0 - until the box is full) */
+    Ensemble_create_fn_t create_fn; /* Function creating the packing of the run */
+    Ensemble_report_fn_t report_fn; /* Function reporting the finished run (NULL - no reports) */
+    void *ctx; /* Context of the functions */
+};
+typedef struct Ensemble Ensemble_t;
+
+/* Methods of ensemble class */
+/* Method for creation of the ensemble of runs_num runs with threads_num additional worker threads
+   (malloc) */
+Ensemble_t* ensemble_create(const u32 runs_num, const u32 threads_num);
+
+/* Method for deleting the ensemble object */
+void ensemble_delete(Ensemble_t *ensemble);
+
+/* Method to run all the packings of the ensemble (run k with seed + k) and wait until they are done */
+void ensemble_run(Ensemble_t *ensemble, const u64 seed, const u32 max_circles, Ensemble_create_fn_t create_fn,
+                  Ensemble_report_fn_t report_fn, void *ctx);
+
+/* Method to calculate the statistics of the value over all the runs */
+void ensemble_calc_stats(const Ensemble_t *ensemble, const Ensemble_value_t value, Ensemble_stats_t *stats);
+
+#endif // ENSEMBLE_H_
@@ -11,15 +11,6 @@
 /* Trim the value to the low and hight bound */
 f32 trim(f32 value, f32 low_bnd, f32 hight_bnd);
 
-/* Function for generation random u32 number from the specific range */
-u32 rnd_int_range(u32 left_bnd, u32 right_bnd);
-
-/* Function to generate the random number in range [0.0, 1.0) */
-f32 rnd_f32(void);
-
-/* Function for generation random f32 number from specific range */
-f32 rnd_f32_range(f32 left_bnd, f32 right_bnd);
-
 /* Function for printing the error end exiting the program */
 void print_error_and_exit(char *text);
 
@@ -32,7 +23,25 @@ f32** dynamic_2d_f32_array_alloc(u32 N, u32 M);
 /* Function for memory free of the 2d array */
 void dynamic_2d_f32_array_free(f32 **array, u32 N);
 
+/* Function for dynamic allocation of the memory aligned by the alignment (power of two) */
+void* aligned_memory_alloc(size_t size, size_t alignment);
+
+/* Function for memory free of the memory allocated by aligned_memory_alloc */
+void aligned_memory_free(void *memory);
+
+/* Function for dynamic allocation of 1d array of f32 elements aligned for SIMD loads (32 bytes) */
+f32* dynamic_1d_f32_aligned_alloc(u32 N);
+
+/* Function for memory free of the aligned 1d array */
+void dynamic_1d_f32_aligned_free(f32 *array);
+
 /* Function for check the collision of two rectangles */
 b32 rectangles_are_collide(V2_u32_t BL_1, V2_u32_t UR_1, V2_u32_t BL_2, V2_u32_t UR_2);
 
+/* Function for the exact integer square root (the largest s with s * s <= n) */
+u32 isqrt_u32(u32 n);
+
+/* Function for the exact integer square root of the 64-bit number */
+u64 isqrt_u64(u64 n);
+
 #endif //MISC_H_
@@ -0,0 +1,44 @@
+/*================================================================================*/
+/* Header file for the overlap kernels (batched tests of the circles interceptions) */
+/*================================================================================*/
+#ifndef OVERLAP_H_
+#define OVERLAP_H_
+
+#include <utils.h>
+
+/* Circles are tested in the SoA lanes padded to the multiple of this number of elements */
+#define OVERLAP_LANE_WIDTH 8
+
+/* Coordinate of the padding elements of the lanes (never intercepts the circles of the box). The
+   distances to it stay below 2^31, so the squares and their sums fit into 63 bits */
+#define OVERLAP_FAR_COORDINATE (-(1 << 30))
+
+/* Overlap kernels (the fastest one supported by the CPU is used by overlap_any) */
+enum Overlap_kernel {
+    OVERLAP_KERNEL_SCALAR, /* One circle per step (the reference) */
+    OVERLAP_KERNEL_SSE2, /* 2 x 4 circles per step */
+    OVERLAP_KERNEL_AVX2, /* 2 x 8 circles per step, the last 8 circles separately */
+    OVERLAP_KERNELS_NUM
+};
+typedef enum Overlap_kernel Overlap_kernel_t;
+
+/* Function to select the fastest overlap kernel supported by the CPU (AVX2, SSE2 or scalar). The
+   selection is made once, the next calls (also from other threads) only wait for it */
+void overlap_select_kernels(void);
+
+/* Function to check if the circle (x0, y0, r0) intercepts (or touches) any of n circles of the
+   lanes xs, ys, rs (aligned by 32 bytes, n is multiple of OVERLAP_LANE_WIDTH). The test is
+   (x - x0)^2 + (y - y0)^2 <= (r + r0)^2 in 64-bit integers, so it is exact for all the coordinates
+   below 2^30 and gives the same result with every kernel */
+b32 overlap_any(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0, const s32 y0,
+                const s32 r0);
+
+/* Function to check if the kernel is compiled for the target and supported by the CPU */
+b32 overlap_kernel_is_supported(const Overlap_kernel_t kernel);
+
+/* Function to check the interception as overlap_any, but by the given supported kernel (for the
+   comparison of the kernels with the scalar one) */
+b32 overlap_any_with(const Overlap_kernel_t kernel, const s32 *xs, const s32 *ys, const s32 *rs, const u32 n,
+                     const s32 x0, const s32 y0, const s32 r0);
+
+#endif // OVERLAP_H_
@@ -0,0 +1,90 @@
+/*================================================================================*/
+/* Header file for the packing class (platform independent simulation core).     */
+/*================================================================================*/
+#ifndef PACKING_H_
+#define PACKING_H_
+
+#include <utils.h>
+#include <world.h>
+#include <box.h>
+#include <circle.h>
+#include <pso_algorithm.h>
+#include <thread_pool.h>
+#include <rng.h>
+#include <placement_log.h>
+
+/* Engines of the circle placement */
+enum Packing_engine {
+    PACKING_ENGINE_PSO, /* Stochastic search with the PSO algorithm */
+    PACKING_ENGINE_CONTACT /* Deterministic choice among the touching positions (contact engine) */
+};
+typedef enum Packing_engine Packing_engine_t;
+
+/* Circle of the speculative batch (searched concurrently with the other circles of the batch) */
+struct Packing_slot {
+    u32 radius; /* Radius of the circle */
+    u32 color; /* Color of the circle */
+    PSO_result_t result; /* Result of the last search of the circle position */
+    b32 is_searched; /* Flag that the result is not outdated by the conflict */
+    Circle_t *circle; /* Committed circle (NULL - not committed yet) */
+};
+typedef struct Packing_slot Packing_slot_t;
+
+/* Structure of the packing run */
+struct Packing {
+    Box_t *box; /* Box where circles are being packed */
+    Packing_engine_t engine; /* Engine of the circle placement */
+    PSO_t *pso; /* PSO algorithm for searching the circle place in box (NULL - other engine) */
+    Thread_pool_t *thread_pool; /* Pool of worker threads for the PSO (NULL - single thread) */
+    u32 speculation_num; /* Number of the circles searched concurrently (1 - one by one) */
+    PSO_t **psos; /* PSO objects of the concurrent searches (the first one is pso) */
+    Packing_slot_t *slots; /* Circles of the current speculative batch */
+    u32 *search_indices; /* Temporary array of the slots searched in the round of the batch */
+    u32 slots_num; /* Number of the committed circles of the batch */
+    u32 slots_next; /* Index of the next committed circle of the batch returned by the step */
+    Rng_t rng; /* Random numbers generator for the circles parameters */
+    u64 seed; /* Seed of the packing run (the same seed gives the same packing) */
+    u32 box_width_out; /* Outer width of the box (in pix) */
+    u32 box_height_out; /* Outer height of the box (in pix) */
+    b32 is_finished; /* Flag that the last search has failed (box is full) */
+    u64 searches_num; /* Total number of performed searches */
+    u64 iterations_num; /* Total number of PSO iterations of all the searches */
+    u64 evaluations_num; /* Total number of the cost evaluations of all the searches */
+    u64 infeasible_num; /* Total number of the cost evaluations with interception */
+    u64 cache_hits; /* Total number of the cost evaluations taken from the PSO cache */
+    u64 cache_misses; /* Total number of the cost evaluations not found in the PSO cache */
+    u64 pruned_num; /* Total number of the cost evaluations resolved by the skyline */
+    u64 conflicts_num; /* Total number of the speculative positions taken by the earlier circles */
+    Placement_log_t *placement_log; /* Log of the placed circles (NULL - no log, not owned) */
+};
+typedef struct Packing Packing_t;
+
+/* Methods of packing class */
+/* Method for creation of the packing object with the placement engine and the box spatial index.
+   PSO engine uses n_islands swarms of n_pop particles and threads_num additional worker threads
+   (malloc) */
+Packing_t* packing_create(const Packing_engine_t engine, const Box_index_t index_type, const u32 n_pop,
+                          const u32 n_islands, const u32 threads_num);
+
+/* Method for deleting the packing object */
+void packing_delete(Packing_t *packing);
+
+/* Method to set the outer size of the box (used by the next initialization) */
+void packing_set_box_size(Packing_t *packing, const u32 box_width_out, const u32 box_height_out);
+
+/* Method to set the number of the circles searched concurrently by the PSO engine against the same
+   state of the box (1 - one by one). Should be set before the initialization */
+void packing_set_speculation(Packing_t *packing, const u32 speculation_num);
+
+/* Method to set the log receiving the event of every placed circle (NULL - no log). The log is
+   owned by the caller */
+void packing_set_placement_log(Packing_t *packing, Placement_log_t *placement_log);
+
+/* Initialization (reset) of the packing object and its box and pso objects. The box is placed in
+   the world above the text panel or at the origin without the world (NULL) */
+void packing_init(Packing_t *packing, World_t *world, const u32 text_panel_height, const u64 seed);
+
+/* Method for placing one new circle into the box. Return NULL when the box is full */
+Circle_t* packing_step(Packing_t *packing);
+
+#endif // PACKING_H_
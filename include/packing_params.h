@@ -0,0 +1,47 @@
+/*================================================================================*/
+/* Header file with the hard-coded parameters of the packing simulation           */
+/*================================================================================*/
+#ifndef PACKING_PARAMS_H_
+#define PACKING_PARAMS_H_
+
+#include <utils.h>
+
+/* Circles parameters as hard-coded circles parameters */
+#define CIRCLES_TYPES 5 /* Number of different types of circles */
+static const u32 CIRCLES_COL[CIRCLES_TYPES] = {0x6daf43, 0x4870c8, 0xea8036, 0xaa1036, 0xaaff36}; /* Circles colors */
+static const f32 CIRCLES_PROB[CIRCLES_TYPES] = {0.20f, 0.20f, 0.20f, 0.20f, 0.20f}; /* Probabilities of appearence */
+static const u32 CIRCLES_RADIUSES[CIRCLES_TYPES] = {3, 5, 3, 5, 3}; /* Circles radiuses in pixels */
+
+/* Box constants */
+static const u32 BOX_WIDTH_OUT = 366;
+static const u32 BOX_HEIGHT_OUT = 500;
+static const u32 BOX_WALL_WIDTH = 15;
+static const u32 BOX_WALL_CLR = 0x7a623e;
+static const u32 BOX_INTERIOR_CLR = 0x443723;
+static const b32 BOX_USE_SUBPIXEL = false; /* Place the circles centers with the sub-pixel precision */
+
+/* PSO algorithm parameters */
+static const u32 PSO_N_VAR = 2;
+static const f32 PSO_VAR_MIN = 0.0f;
+static const f32 PSO_VAR_MAX = 1.0f;
+static const b32 PSO_USE_ITER_LIMIT = true;
+static const u32 PSO_ITER_LIMIT = 1000;
+static const u32 PSO_N_POP = 10;
+static const f32 PSO_W_INIT = 1.0;
+static const f32 PSO_W_DAMP = 0.99;
+static const f32 PSO_C1 = 2.0;
+static const f32 PSO_C2 = 2.0;
+static const u32 PSO_A = 5;
+static const u32 PSO_B = 200;
+static const u32 PSO_MIGRATION_INTERVAL = 50;
+static const u32 PSO_STALL_LIMIT = 100; /* Iterations without improvement to stop (0 - off) */
+static const f32 PSO_SPREAD_TOL = 0.5f; /* Spread of the swarm (in pix) to stop (0.0 - off) */
+static const f32 PSO_WARM_FRACTION = 0.5f; /* Fraction of the warm started particles (0.0 - off) */
+static const u32 PSO_WARM_SPREAD = 10; /* Seeding distance (in pix) around the warm start points */
+static const f32 PSO_SURFACE_FRACTION = 0.25f; /* Fraction of the particles seeded above the skyline (0.0 - off) */
+static const u32 PSO_SURFACE_SPREAD = 10; /* Height of the seeding band (in pix) above the skyline */
+static const b32 PSO_USE_PRUNING = false; /* Resolve the candidates not improving the bests by the skyline */
+static const b32 PSO_USE_OPEN_SAMPLING = true; /* Randomize the particles only in the open tiles of the box */
+static const u32 PSO_SPECULATION_NUM = 1; /* Circles searched concurrently against the same box (1 - one by one) */
+
+#endif // PACKING_PARAMS_H_
@@ -0,0 +1,75 @@
+/*================================================================================*/
+/* Header file for the placement_log class (streaming log of the placed circles). */
+/*================================================================================*/
+#ifndef PLACEMENT_LOG_H_
+#define PLACEMENT_LOG_H_
+
+#include <stdio.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <utils.h>
+
+/* Number of the events in the ring between the placement and the writer threads (power of two) */
+#define PLACEMENT_LOG_RING_SIZE (1u << 16)
+
+/* Size of the output buffer of the writer thread (the file is written by the blocks of this size) */
+#define PLACEMENT_LOG_BUFFER_SIZE (1u << 20)
+
+/* Signature of the binary log ("CPLG" in the file) and the version of its format */
+#define PLACEMENT_LOG_MAGIC 0x474c5043u
+#define PLACEMENT_LOG_VERSION 1
+
+/* Encodings of the placement log */
+enum Placement_log_format {
+    PLACEMENT_LOG_BINARY, /* Header, then the records of 7 little-endian u32 (cost as f32 bits) */
+    PLACEMENT_LOG_CSV, /* Header line, then one line per event */
+    PLACEMENT_LOG_NDJSON /* One JSON object per line */
+};
+typedef enum Placement_log_format Placement_log_format_t;
+
+/* Event of the placed circle */
+struct Placement_event {
+    u32 index; /* Index of the circle in the box */
+    V2_u32_t position; /* Coordinates (in the geometry units of the box) of the circle center */
+    u32 radius; /* Radius of the circle (in pix) */
+    u32 color; /* Color of the circle */
+    u32 iterations; /* Number of the PSO iterations of the search (0 - contact engine) */
+    f32 cost; /* Cost of the circle position */
+};
+typedef struct Placement_event Placement_event_t;
+
+/* Structure of the placement log. The events are pushed by one placement thread into the lock-free
+   ring and encoded and written by the own writer thread */
+struct Placement_log {
+    FILE *file; /* File of the log */
+    Placement_log_format_t format; /* Encoding of the events */
+    u32 subpixel_bits; /* Sub-pixel bits of the box geometry units (0 - centers in pix) */
+    Placement_event_t *events; /* Ring of the events (PLACEMENT_LOG_RING_SIZE elements) */
+    _Atomic u64 head; /* Number of the pushed events (changed by the placement thread only) */
+    u8 head_padding[64]; /* Padding keeping head and tail in the different cache lines */
+    _Atomic u64 tail; /* Number of the encoded events (changed by the writer thread only) */
+    u8 tail_padding[64]; /* Padding keeping tail apart from the fields below */
+    atomic_int is_stopping; /* Flag for the writer thread to write the rest of the events and exit */
+    pthread_t thread; /* Writer thread */
+    pthread_mutex_t mutex; /* Mutex of the wake up condition */
+    pthread_cond_t wake_cond; /* Condition for the writer: the ring is half full or the log is stopping */
+    u8 *buffer; /* Output buffer of the writer thread */
+    size_t buffer_size; /* Number of the bytes in the output buffer */
+    b32 is_failed; /* Flag that the file writing has failed (set by the writer thread) */
+};
+typedef struct Placement_log Placement_log_t;
+
+/* Methods of placement_log class */
+/* Method for creation of the placement log writing to the file in the format (malloc, starts the
+   writer thread). Returns NULL if the file can't be opened */
+Placement_log_t* placement_log_create(const char *file_path, const Placement_log_format_t format,
+                                      const u32 subpixel_bits);
+
+/* Method for deleting the placement log: the rest of the events is written and the file is closed.
+   Returns false if any of the events could not be written */
+b32 placement_log_delete(Placement_log_t *log);
+
+/* Method to push the event into the log (waits only when the ring is full) */
+void placement_log_push(Placement_log_t *log, const Placement_event_t *event);
+
+#endif // PLACEMENT_LOG_H_
@@ -6,8 +6,52 @@
 
 #include <utils.h>
 #include <circle.h>
-#include <circles_list.h>
 #include <box.h>
+#include <thread_pool.h>
+#include <rng.h>
+
+/* Entry of the cost cache (cost of the circle center at the pixel) */
+struct PSO_cache_entry {
+    u32 x, y; /* Coordinates (in pix) of the circle center (the key) */
+    u32 generation; /* Search generation when the entry was stored (other - empty entry) */
+    b32 is_feasible; /* Flag that there is no interception at the pixel */
+    f32 cost; /* Cost at the pixel */
+};
+typedef struct PSO_cache_entry PSO_cache_entry_t;
+
+/* Structure of the one swarm (island) of particles */
+struct PSO_swarm {
+    u32 iteration; /* Total number of iterations */
+    b32 is_solution_found; /* Flag to tetermine the result of PSO search */
+    f32 *part_positions; /* Positions of all particles (x lane, then y lane, SoA layout) */
+    f32 *part_best_positions; /* Best positions of all particles (x lane, then y lane) */
+    f32 *part_velocities; /* Velocities of all particles (x lane, then y lane) */
+    f32 *part_costs; /* Array for particles costs */
+    b32 *part_feasible; /* Array of flags that the particle position has no interceptions */
+    f32 *part_best_costs; /* Array for best particles costs */
+    f32 global_best_cost; /* Global closest distance to the bottom of the box */
+    f32 *global_best_position; /* Best position is a vector of 2 float numbers */
+    f32 w; /* Current inertia coefficient */
+    f32 *r1; /* Random numbers r1 for every particle and variable (same layout as positions) */
+    f32 *r2; /* Random numbers r2 for every particle and variable (same layout as positions) */
+    Rng_t rng; /* Own random numbers generator of the swarm */
+    u32 stall_iterations; /* Number of iterations without improvement of the global best cost */
+    b32 is_converged; /* Flag that the swarm has met the early termination criteria */
+    u32 infeasible_num; /* Number of evaluations with interception in the current search */
+    u32 *part_pixels; /* Coordinates (in pix) of particles centers (x lane, then y lane) */
+    u32 *eval_indices; /* Indices of particles to be evaluated in the current iteration (cache misses) */
+    u32 eval_num; /* Number of particles to be evaluated in the current iteration */
+    u32 *eval_pixels; /* Centers (in the geometry units) of the evaluated particles (x lane, then y) */
+    f32 *eval_costs; /* Costs of the evaluated particles in the list order */
+    b32 *eval_feasible; /* Feasibility flags of the evaluated particles in the list order */
+    PSO_cache_entry_t *cache; /* Open addressing cache of the costs valid for one search */
+    u32 cache_generation; /* Generation of the current search (clears the cache in O(1)) */
+    u32 cache_used; /* Number of entries stored in the current search */
+    u32 cache_hits; /* Number of cache hits in the current search */
+    u32 cache_misses; /* Number of cache misses in the current search */
+    u32 pruned_num; /* Number of evaluations resolved by the skyline in the current search */
+};
+typedef struct PSO_swarm PSO_swarm_t;
 
 /* Structure of the PSO algorithm */
 struct PSO {
@@ -17,27 +61,32 @@ struct PSO {
     f32 var_max; /* Maximum value of the variables (0.0...1.0) */
     b32 use_iter_limit; /* Flag whether to use iterations limit or no */
     u32 iter_limit; /* Limit of iterations */
-    u32 n_pop; /* Population number */
+    u32 n_pop; /* Population number (of every swarm) */
     f32 w_init; /* Initial inertia coefficient */
     f32 w_damp; /* Damping ratio of the inertia coefficient */
     f32 c1; /* Personal acceleration coefficient */
     f32 c2; /* Social acceleration coefficient */
     u32 a; /* Additional particles randomization */
     u32 b; /* Additional swarm randomization */   
+    u32 migration_interval; /* Number of iterations between the migrations of the islands best */
+    u32 stall_limit; /* Iterations without improvement of the global best to stop (0 - not used) */
+    f32 spread_tol; /* Spread of the particles best positions (in pix) to stop (0.0 - not used) */
+    f32 warm_fraction; /* Fraction of particles seeded around the warm start points (0.0 - not used) */
+    u32 warm_spread; /* Half size of the square (in pix) around the warm start point for seeding */
+    b32 use_cache; /* Flag to use the cache of the costs evaluations */
+    f32 surface_fraction; /* Fraction of particles seeded above the skyline (0.0 - not used) */
+    u32 surface_spread; /* Height (in pix) of the band above the skyline for seeding */
+    b32 use_pruning; /* Flag to resolve the candidates which can't improve the bests by the skyline */
+    b32 use_open_sampling; /* Flag to randomize the particles only in the open tiles of the box */
 
-    u32 iteration; /* Total number of iterations */
-    b32 is_solution_found; /* Flag to tetermine the result of PSO search */
-    f32 **part_positions; /* 2D array for positions of all particles */
-    f32 *tmp_position; /* Array for temporary position of one particle */
-    f32 **part_best_positions; /* 2D array for best positions of all particles */
-    f32 **part_velocities; /* 2D array for particles velocities */
-    f32 *part_costs; /* Array for particles costs */
-    f32 *part_best_costs; /* Array for best particles costs */
-    f32 global_best_cost; /* Global closest distance to the bottom of the box */
-    f32 *global_best_position; /* Best position is a vector of 2 float numbers */
-    f32 w; /* Current inertia coefficient */
-    f32 r1; /* Random numbers r1 */
-    f32 r2; /* Random numbers r2 */   
+    u32 n_pop_pad; /* Population number rounded up to the SIMD width (length of every lane) */
+    u32 n_islands; /* Number of independent swarms (islands) */
+    PSO_swarm_t *swarms; /* Array of the swarms (islands) */
+    Thread_pool_t *thread_pool; /* Pool for the parallel work (NULL - everything is serial) */
+    V2_u32_t *warm_points; /* Ring of the recent placements and free positions (in pix) */
+    u32 warm_points_capacity; /* Capacity of the warm start points ring */
+    u32 warm_points_num; /* Number of the valid warm start points */
+    u32 warm_points_next; /* Index in the ring for the next point */
 };
 typedef struct PSO PSO_t;
 
@@ -45,12 +94,18 @@ typedef struct PSO PSO_t;
 struct PSO_result {
     b32 is_solution_found; /* Flag to tetermine the result of PSO search */
     V2_u32_t global_best_coordinates; /* Best coordinates is a vector of 2 unsigned numbers */
+    u32 iterations; /* Number of iterations actually done (the largest among the islands) */
+    u32 evaluations_num; /* Number of the cost evaluations of all islands */
+    u32 infeasible_num; /* Number of the cost evaluations with interception of all islands */
+    u32 cache_hits; /* Number of the cost evaluations taken from the cache */
+    u32 cache_misses; /* Number of the cost evaluations not found in the cache */
+    u32 pruned_num; /* Number of the cost evaluations resolved by the skyline */
 };
 typedef struct PSO_result PSO_result_t;
 
 /* Methods of PSO class */
-/* Method for creation of the pso algorithm object (malloc) */
-PSO_t* pso_create(const u32 n_var, const u32 n_pop);
+/* Method for creation of the pso algorithm object with n_islands swarms of n_pop particles (malloc) */
+PSO_t* pso_create(const u32 n_var, const u32 n_pop, const u32 n_islands);
 
 /* Method for deleting the pso algorithm object */
 void pso_delete(PSO_t *pso);
@@ -58,18 +113,41 @@ void pso_delete(PSO_t *pso);
 /* Initialization of the PSO algorithm */
 void pso_init(PSO_t *pso, const f32 var_min, const f32 var_max, const b32 use_iter_limit,
               const u32 iter_limit, const f32 w_init, const f32 w_damp, const f32 c1, const f32 c2,
-              const u32 a, const u32 b);
+              const u32 a, const u32 b, const u32 migration_interval);
 
-/* Method for deleting the PSO algorithm object */
-void pso_delete(PSO_t *pso);
+/* Method to seed the random numbers generators of all swarms (island k uses the stream
+   first_stream + k) */
+void pso_seed(PSO_t *pso, const u64 seed, const u64 first_stream);
+
+/* Method to set the early termination criteria of the search (stagnation and spread of the swarm) */
+void pso_set_early_termination(PSO_t *pso, const u32 stall_limit, const f32 spread_tol);
+
+/* Method to set the warm start: part of the particles is seeded around the recent placements and
+   the free positions found by the previous searches */
+void pso_set_warm_start(PSO_t *pso, const f32 warm_fraction, const u32 warm_spread);
+
+/* Method to enable or disable the cache of the costs evaluations (enabled by default) */
+void pso_set_cost_cache(PSO_t *pso, const b32 use_cache);
+
+/* Method to set the surface start: part of the particles is seeded in the band just above the
+   skyline of the box (the fill surface) */
+void pso_set_surface_start(PSO_t *pso, const f32 surface_fraction, const u32 surface_spread);
+
+/* Method to enable or disable the pruning of the candidates which can't improve the bests of the
+   swarm (they are resolved by the skyline without the collision check) */
+void pso_set_pruning(PSO_t *pso, const b32 use_pruning);
+
+/* Method to enable or disable the sampling of the random particles positions only from the open
+   (not saturated) tiles of the box */
+void pso_set_open_sampling(PSO_t *pso, const b32 use_open_sampling);
 
 /* Method to start the search of circle coordinates and return the results */
 PSO_result_t pso_run_search(PSO_t *pso, const Box_t *box, const u32 radius); 
 
-/* Method to calculate cost function for the current circle */
-f32 pso_calculate_cost(PSO_t *pso, const Box_t *box, const u32 radius);
+/* Method to set the thread pool for the parallel islands or costs evaluation (NULL - serial work) */
+void pso_set_thread_pool(PSO_t *pso, Thread_pool_t *thread_pool);
 
-/* Method to calculate the coordinates from the found best solution */
-V2_u32_t pso_calc_coordinates(PSO_t *pso, const Box_t *box, const u32 radius);
+/* Method to calculate the coordinates (in pix) from the found best position */
+V2_u32_t pso_calc_coordinates(const Box_t *box, const u32 radius, const f32 *position);
 
 #endif /* PSO_ALG_H_ */
@@ -0,0 +1,61 @@
+/*================================================================================*/
+/* Header file for the quadtree class (loose quadtree of the packed circles).     */
+/*================================================================================*/
+#ifndef QUADTREE_H_
+#define QUADTREE_H_
+
+#include <utils.h>
+#include <circle.h>
+
+/* Callback of the query for every found record. Returns true to stop the query */
+typedef b32 (*Quadtree_visit_fn_t)(void *data, const Circle_record_t *record);
+
+/* Node of the quadtree. The node covers the square [x_min, x_min + 2 * half) along both axes and
+   keeps the circles centered in it with the radius up to half, which are not small enough for the
+   child nodes. So all the circles of the node subtree are inside its loose square (the square
+   expanded by the largest radius of the subtree, at most twice larger) */
+struct Quadtree_node {
+    u32 x_min; /* X coordinate of the left side of the node square */
+    u32 y_min; /* Y coordinate of the bottom side of the node square */
+    u32 half; /* Half of the side of the node square (power of two) */
+    u32 max_radius; /* Largest radius of the circles in the node subtree */
+    u32 children[4]; /* Indices of the child nodes (0 - no child, the root is never a child) */
+    Circle_record_t *records; /* Growable array of the records of the node circles */
+    u32 records_num; /* Number of the records in the node */
+    u32 records_capacity; /* Capacity of the records array */
+};
+typedef struct Quadtree_node Quadtree_node_t;
+
+/* Structure of the quadtree class */
+struct Quadtree {
+    Quadtree_node_t *nodes; /* Array of the nodes (the root is the first one) */
+    u32 nodes_num; /* Number of the used nodes */
+    u32 nodes_capacity; /* Number of the allocated nodes (records memory of the unused is kept) */
+    u32 min_half; /* Smallest half side of the nodes (limits the depth for the small circles) */
+    u32 records_num; /* Number of the records in the whole tree */
+};
+typedef struct Quadtree Quadtree_t;
+
+/* Methods of quadtree class */
+/* Method for creation of the empty quadtree object (malloc) */
+Quadtree_t* quadtree_create(void);
+
+/* Method for deleting the quadtree object (free) */
+void quadtree_delete(Quadtree_t *quadtree);
+
+/* Initialization (reset) of the quadtree covering the centers in the rectangle of width x height */
+void quadtree_init(Quadtree_t *quadtree, const u32 x_min, const u32 y_min, const u32 width,
+                   const u32 height, const u32 min_half);
+
+/* Method for the incremental insert of the circle record */
+void quadtree_insert(Quadtree_t *quadtree, const Circle_record_t *record);
+
+/* Method for the bulk build of the tree from the array of records (previous records are removed) */
+void quadtree_build(Quadtree_t *quadtree, const Circle_record_t *records, const u32 records_num);
+
+/* Method to visit the records of the circles which can intersect the square of half side reach
+   around (x0, y0). Returns true if the query was stopped by the callback */
+b32 quadtree_query(const Quadtree_t *quadtree, const u32 x0, const u32 y0, const u32 reach,
+                   Quadtree_visit_fn_t visit, void *data);
+
+#endif // QUADTREE_H_
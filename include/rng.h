@@ -0,0 +1,38 @@
+/*================================================================================*/
+/* Header file for the rng class (seedable random numbers generator).            */
+/*================================================================================*/
+#ifndef RNG_H_
+#define RNG_H_
+
+#include <utils.h>
+
+/* Number of interleaved generators in one rng object (width of the SSE register) */
+#define RNG_LANES 4
+
+/* Structure of the random numbers generator. There are RNG_LANES interleaved xoshiro128+
+   generators advanced together. Every step gives RNG_LANES numbers, they are consumed in order, so
+   single draws and bulk fills give the same sequence for the same seed */
+struct Rng {
+    u32 s[4][RNG_LANES]; /* States of the generators (word-major: s[word][lane]) */
+    u32 out[RNG_LANES]; /* Output of the last step not consumed yet */
+    u32 out_index; /* Index of the next number in out (RNG_LANES - out is empty) */
+};
+typedef struct Rng Rng_t;
+
+/* Methods of rng class */
+/* Method to seed the generator. Different stream numbers give independent sequences */
+void rng_seed(Rng_t *rng, const u64 seed, const u64 stream);
+
+/* Method to generate the random u32 number */
+u32 rng_u32(Rng_t *rng);
+
+/* Method to generate the random number in range [0.0, 1.0) */
+f32 rng_f32(Rng_t *rng);
+
+/* Method to generate the random f32 number from specific range [left_bnd, right_bnd) */
+f32 rng_f32_range(Rng_t *rng, const f32 left_bnd, const f32 right_bnd);
+
+/* Method to fill the buffer with N random numbers in range [0.0, 1.0) (vectorized) */
+void rng_fill_f32(Rng_t *rng, f32 *buffer, const u32 N);
+
+#endif // RNG_H_
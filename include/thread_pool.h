@@ -0,0 +1,41 @@
+/*================================================================================*/
+/* Header file for the thread_pool class.                                         */
+/*================================================================================*/
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <pthread.h>
+#include <utils.h>
+
+/* Function executing one task of the parallel job (task_index is 0...tasks_num-1) */
+typedef void (*Thread_pool_task_fn_t)(void *task_ctx, u32 task_index);
+
+/* Structure of the pool of persistent worker threads */
+struct Thread_pool {
+    u32 threads_num; /* Number of worker threads (calling thread works as well) */
+    pthread_t *threads; /* Array of the worker threads */
+    pthread_mutex_t mutex; /* Mutex protecting the job fields below */
+    pthread_cond_t job_cond; /* Condition for the workers: new job is available */
+    pthread_cond_t done_cond; /* Condition for the caller: all tasks of the job are done */
+    Thread_pool_task_fn_t task_fn; /* Function of the current job */
+    void *task_ctx; /* Context of the current job */
+    u32 tasks_num; /* Total number of tasks in the current job */
+    u32 next_task; /* Index of the next task to be taken */
+    u32 tasks_done; /* Number of already finished tasks */
+    u32 job_id; /* Incremented for every new job (wakes up the workers) */
+    b32 is_stopping; /* Flag for the workers to exit */
+};
+typedef struct Thread_pool Thread_pool_t;
+
+/* Methods of thread_pool class */
+/* Method for creation of the thread pool object with threads_num worker threads (malloc) */
+Thread_pool_t* thread_pool_create(const u32 threads_num);
+
+/* Method for deleting the thread pool object (joins all worker threads) */
+void thread_pool_delete(Thread_pool_t *pool);
+
+/* Method to execute tasks_num tasks in parallel and wait until all of them are done (barrier) */
+void thread_pool_run(Thread_pool_t *pool, Thread_pool_task_fn_t task_fn, void *task_ctx,
+                     const u32 tasks_num);
+
+#endif // THREAD_POOL_H_
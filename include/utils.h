@@ -2,7 +2,9 @@
 #define UTILS_H_
 
 #include <stdint.h>
+#ifdef _WIN32
 #include <windows.h>
+#endif
 
 /* Type synonims for easy use */
 typedef int8_t s8;
@@ -86,7 +88,9 @@ struct Render_Buffer {
     u32 height;
     u32 *pixels;
     /* Platform specific part */
+#ifdef _WIN32
     BITMAPINFO bitmap_info;
+#endif
 };
 typedef struct Render_Buffer Render_Buffer_t;
 
@@ -0,0 +1,113 @@
+/*================================================================================*/
+/* Realization of arena methods                                                   */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <assert.h>
+
+/* Program includes: */
+#include <arena.h>
+#include <utils.h>
+#include <misc.h>
+
+/* Alignment of the blocks memory (the largest supported alignment of the allocations) */
+#define ARENA_BLOCK_ALIGNMENT 64
+
+/* Static functions */
+/* Function to make the block at the index able to keep size bytes (allocated or replaced) */
+static void arena_prepare_block(Arena_t *arena, const u32 index, const size_t size);
+
+Arena_t*
+arena_create(const size_t block_size)
+{
+    /* Method for creation of the empty arena (malloc). Blocks are allocated by the first
+       allocations */
+    Arena_t *tmp_arena;
+
+    tmp_arena = (Arena_t *) calloc (1, sizeof(Arena_t));
+    if (NULL == tmp_arena) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_arena->block_size = block_size;
+    return tmp_arena;
+}
+
+void
+arena_delete(Arena_t *arena)
+{
+    /* Method for deleting the arena with all its blocks (free) */
+    u32 i;
+
+    for (i = 0; i < arena->blocks_num; ++i) {
+        aligned_memory_free(arena->blocks[i].memory);
+    }
+    free(arena->blocks);
+    free(arena);
+}
+
+static void
+arena_prepare_block(Arena_t *arena, const u32 index, const size_t size)
+{
+    /* Function to make the block at the index able to keep size bytes. The new block is appended
+       (blocks array grows twice), the kept block smaller than the size is replaced */
+    Arena_block_t *tmp_blocks;
+    Arena_block_t *block;
+    size_t block_size;
+
+    if (index == arena->blocks_num) {
+        if (arena->blocks_num == arena->blocks_capacity) {
+            arena->blocks_capacity = (arena->blocks_capacity > 0) ? 2 * arena->blocks_capacity : 8;
+            tmp_blocks = (Arena_block_t *) realloc (arena->blocks, arena->blocks_capacity * sizeof(Arena_block_t));
+            if (NULL == tmp_blocks) print_error_and_exit("Error in memory allocation!\n");
+            arena->blocks = tmp_blocks;
+        }
+        arena->blocks[index].memory = NULL;
+        arena->blocks[index].size = 0;
+        arena->blocks_num += 1;
+    }
+
+    block = &arena->blocks[index];
+    if (block->size >= size) {
+        return;
+    }
+
+    /* Size is rounded up to the alignment (the whole block is usable) */
+    block_size = (size > arena->block_size) ? size : arena->block_size;
+    block_size = (block_size + ARENA_BLOCK_ALIGNMENT - 1) / ARENA_BLOCK_ALIGNMENT * ARENA_BLOCK_ALIGNMENT;
+    aligned_memory_free(block->memory);
+    block->memory = (u8 *) aligned_memory_alloc (block_size, ARENA_BLOCK_ALIGNMENT);
+    block->size = block_size;
+}
+
+void*
+arena_alloc(Arena_t *arena, const size_t size, const size_t alignment)
+{
+    /* Method to allocate the memory by bumping the offset of the current block. When the block is
+       full the next one is taken (the worst case size + alignment bytes are reserved in it) */
+    size_t offset;
+
+    assert((alignment > 0) && (alignment <= ARENA_BLOCK_ALIGNMENT) && ((alignment & (alignment - 1)) == 0));
+
+    if (arena->current < arena->blocks_num) {
+        offset = (arena->used + alignment - 1) & ~(alignment - 1);
+        if (offset + size <= arena->blocks[arena->current].size) {
+            arena->used = offset + size;
+            return arena->blocks[arena->current].memory + offset;
+        }
+        arena->current += 1;
+    }
+
+    /* The block starts aligned, so the allocation is at its beginning */
+    arena_prepare_block(arena, arena->current, size);
+    arena->used = size;
+    return arena->blocks[arena->current].memory;
+}
+
+void
+arena_reset(Arena_t *arena)
+{
+    /* Method to release all the allocations in O(1). The blocks are kept, so the same amount of
+       allocations after the reset does not call the system allocator */
+    arena->current = 0;
+    arena->used = 0;
+}
@@ -8,50 +8,127 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <math.h>
+#include <string.h>
+#include <assert.h>
 
 /* Program includes: */
 #include <box.h>
 #include <utils.h>
 #include <world.h>
-#include <circles_list.h>
+#include <arena.h>
 #include <software_rendering.h>
 #include <misc.h>
+#include <contact_engine.h>
+#include <quadtree.h>
+#include <overlap.h>
+
+/* Smallest half side of the quadtree nodes (in pix) */
+#define BOX_QUADTREE_MIN_HALF 4
+
+/* Number of the candidates of the batch query binned together (scratch arrays are on the stack) */
+#define BOX_BATCH_BLOCK 64
+
+/* Size of the blocks of the box arena (in bytes) */
+#define BOX_ARENA_BLOCK_SIZE (1 << 20)
+
+/* Alignment of the lanes of the grid cells (for the AVX loads) */
+#define BOX_LANE_ALIGNMENT 32
+
+/* Result of the clearance raster test of the circle center */
+enum Box_test {
+    BOX_TEST_INFEASIBLE, /* The circle intercepts the packed circles */
+    BOX_TEST_FEASIBLE, /* The circle does not intercept the packed circles */
+    BOX_TEST_SCAN /* The circles of the index have to be checked */
+};
+typedef enum Box_test Box_test_t;
+
+/* Circle checked by the feasibility query (in the geometry units) */
+struct Box_probe {
+    u32 x0; /* X coordinate of the circle center */
+    u32 y0; /* Y coordinate of the circle center */
+    u32 radius; /* Radius of the circle */
+};
+typedef struct Box_probe Box_probe_t;
 
 /* Static functions */
-/* Function for calculation the box blocks parameters */
-static void box_calc_blocks_params(Box_t *box);
+/* Function for the allocation (or reset) of the grid cells of the box */
+static void box_cells_init(Box_t *box);
+/* Function to get the grid cell (NULL if its block has no circles yet) */
+static Box_cell_t* box_cell_at(const Box_t *box, const u32 cx, const u32 cy);
+/* Function to get the grid cell for the new circle (its block is allocated in the box arena) */
+static Box_cell_t* box_cell_get(Box_t *box, const u32 cx, const u32 cy);
+/* Function to get the grid cell of the circle center (in the geometry units) */
+static void box_cell_of(const Box_t *box, const u32 x, const u32 y, u32 *cx, u32 *cy);
+/* Function to move the records array and the lanes of the cell to the larger ones (in the box arena) */
+static void box_cell_reserve(Box_t *box, Box_cell_t *cell, const u32 capacity);
+/* Function for the bulk placement of the records into the grid cells */
+static void box_cells_build(Box_t *box, const Circle_record_t *records, const u32 records_num);
+/* Function for the initialization of the clearance raster of the empty box */
+static void box_clearance_init(Box_t *box);
+/* Function to get the clearance of the raster pixel limited by the walls and the floor only */
+static u32 box_clearance_wall(const Box_t *box, const u32 x, const u32 y);
+/* Function to get the largest clearance limited by the walls along one axis in the range of pixels */
+static u32 box_clearance_wall_max(const u32 size, const u32 begin, const u32 end, const u32 cap);
+/* Function to get the pixels of the open tile (allocated by the first call) */
+static u16* box_clearance_pixels(Box_t *box, const u32 tile_x, const u32 tile_y);
+/* Function to get the clearance of the raster pixel (false if the tile is saturated) */
+static b32 box_clearance_get(const Box_t *box, const u32 x, const u32 y, u32 *value);
+/* Function for the update of the clearance raster around the added circle */
+static void box_clearance_add_circle(Box_t *box, const Circle_t *circle);
+/* Function for the update of the maximum clearance and the saturation of the tile */
+static void box_clearance_update_tile(Box_t *box, const u32 tile_x, const u32 tile_y);
+/* Function for the initialization of the skyline of the empty box */
+static void box_skyline_init(Box_t *box);
+/* Function for the update of the skyline columns covered by the added circle */
+static void box_skyline_add_circle(Box_t *box, const Circle_t *circle);
+/* Function to create the circle object of the record and append it to the packed circles */
+static Circle_t* box_circle_create(Box_t *box, const Circle_record_t *record, const u32 color);
+/* Function to update the box data after the circle has been added to the spatial index */
+static Circle_t* box_add_circle_finish(Box_t *box, const Circle_record_t *record, const u32 color);
+/* Function to test the circle center (in the geometry units) by the clearance raster */
+static Box_test_t box_clearance_test(const Box_t *box, const u32 x0, const u32 y0, const u32 radius);
+/* Function to check the circle (in the geometry units) against the packed circles of the index */
+static b32 box_scan_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius);
+/* Function to check the block of the batch candidates needing the scan of the grid cells */
+static void box_batch_scan(const Box_t *box, const u32 radius, const u32 *xs, const u32 *ys, u32 *pending,
+                           u32 pending_num, b32 *is_feasible);
+/* Function to check the interception of the probe circle with the found record */
+static b32 box_visit_intercept(void *data, const Circle_record_t *record);
 
 Box_t*
-box_create(const u32 blocks_side_num)
+box_create(const u32 min_radius, const u32 max_radius, const Box_index_t index_type)
 {
-    /* Method for creation of the box object (malloc) */
+    /* Method for creation of the box object for the circles with the radiuses min_radius...max_radius
+       (malloc). The grid cells (or the quadtree nodes) and the clearance raster are allocated at
+       the box initialization, when the box size is known */
     Box_t *tmp_box;
-    u32 i, j;
 
     /* Allocate the memory for the box itself */
     tmp_box = (Box_t*) calloc (1, sizeof(Box_t));
     if (NULL == tmp_box) print_error_and_exit("Error in memory allocation!\n");
 
-    /* Allocate the memory for box blocks */
-    tmp_box->blocks_side_num = blocks_side_num;
-    tmp_box->blocks = (Box_block_t**) calloc (blocks_side_num, sizeof(Box_block_t*));
-    if (NULL == tmp_box->blocks) print_error_and_exit("Error in memory allocation!\n");
+    /* Circles are stored by the cell of the center. The cell is larger than the largest distance
+       of the intercepting centers (2 * max_radius), so the query visits only 3x3 cells */
+    tmp_box->min_radius = min_radius;
+    tmp_box->max_radius = max_radius;
+    tmp_box->cell_side = 2 * max_radius + 1;
 
-    for (i = 0; i < blocks_side_num; ++i) {
-        tmp_box->blocks[i] = (Box_block_t*) calloc (blocks_side_num, sizeof(Box_block_t));
-        if (NULL == tmp_box->blocks[i]) print_error_and_exit("Error in memory allocation!\n");
-    }
-   
-    /* Create circles_list for every created block */
-    for (i = 0; i < blocks_side_num; ++i) {
-        for (j = 0; j < blocks_side_num; ++j) {
-            tmp_box->blocks[i][j].circles_list = circles_list_create();
-        }
+    /* Tiles are counted by their maximum clearance, so the largest one is found without the scan */
+    tmp_box->clearance_counts = (u32 *) calloc (max_radius + 1, sizeof(u32));
+    if (NULL == tmp_box->clearance_counts) print_error_and_exit("Error in memory allocation!\n");
+
+    /* Quadtree keeps the circles at the depth of their size, so the wide distributions of the
+       radiuses do not make the small queries scan the crowded cells */
+    tmp_box->index_type = index_type;
+    overlap_select_kernels();
+    if (index_type == BOX_INDEX_QUADTREE) {
+        tmp_box->quadtree = quadtree_create();
     }
 
-    /* Allocate memory for the list of all packed circles */
-    tmp_box->circles_list = circles_list_create();
-    
+    /* Packed circles and the grid records live in the arena, so the box reset releases them at once
+       and the next run reuses the same memory */
+    tmp_box->arena = arena_create(BOX_ARENA_BLOCK_SIZE);
+
     return tmp_box;
 }
 
@@ -60,38 +137,57 @@ box_delete(Box_t *box)
 {
     /* Method for deleting the box object (free). Delete in reverse order */
 
-    u32 i, j;
-    
-    /* Clear all the packed circle objects */
-    circles_list_empty(box->circles_list, 1);
+    /* 1. Delete all the packed circles and the records of the cells with the arena */
+    arena_delete(box->arena);
+    free(box->circles);
 
-    /* 1. Delete the circles lists, and dont touch circles object, because their pointers can double in 
-       the lists */
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        for (j = 0; j < box->blocks_side_num; ++j) {
-            circles_list_delete(box->blocks[i][j].circles_list, 0);
-        }
+    /* 2. Delete the cell blocks array and the quadtree */
+    free(box->cell_blocks);
+    if (NULL != box->quadtree) {
+        quadtree_delete(box->quadtree);
     }
 
-    /* 2. Delete the blocks array */
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        free(box->blocks[i]);
+    /* 3. Delete the clearance raster and the contact engine */
+    free(box->clearance);
+    free(box->clearance_tiles);
+    free(box->clearance_counts);
+    free(box->open_tiles);
+    free(box->open_tile_slots);
+    free(box->skyline);
+    if (NULL != box->contact_engine) {
+        contact_engine_delete(box->contact_engine);
     }
-    free(box->blocks);
 
-    /* 3. Delete the box */
+    /* 4. Delete the box */
     free(box);
 }
 
+b32
+box_size_is_valid(const u32 box_width_out, const u32 box_height_out, const u32 box_wall_width)
+{
+    /* Method to check the size of the box. The clearance raster covers (width_in + 1) x
+       (height_in + 1) center pixels by the tiles, their number is counted in 64 bits, so the check
+       does not wrap for any size */
+    u64 tiles_x_num, tiles_y_num;
+
+    if ((box_width_out <= 2 * box_wall_width) || (box_height_out <= box_wall_width)) {
+        return false;
+    }
+    tiles_x_num = ((u64)box_width_out - 2 * box_wall_width + BOX_TILE_SIDE) / BOX_TILE_SIDE;
+    tiles_y_num = ((u64)box_height_out - box_wall_width + BOX_TILE_SIDE) / BOX_TILE_SIDE;
+    return tiles_x_num * tiles_y_num <= BOX_MAX_TILES_NUM;
+}
+
 void
-box_init(Box_t *box, World_t *world, const u32 box_width_out, const u32 box_height_out,
-         const u32 box_wall_width, const u32 text_panel_height, const u32 box_wall_clr,
-         const u32 box_interior_clr)
+box_init(Box_t *box, const V2_u32_t BL_out, const u32 box_width_out, const u32 box_height_out,
+         const u32 box_wall_width, const u32 box_wall_clr, const u32 box_interior_clr)
 {
-    /* Initialization of the box object fields */
+    /* Initialization of the box object fields. The box is placed with its bottom-left outer corner
+       at BL_out and does not depend on the display, only the touched parts of the index and the
+       clearance raster take the memory */
+
+    assert(box_size_is_valid(box_width_out, box_height_out, box_wall_width));
 
-    u32 i, j;
-    
     /* Initialization of fields from the parameter list */
     box->width_out = box_width_out;
     box->height_out = box_height_out;
@@ -99,8 +195,8 @@ box_init(Box_t *box, World_t *world, const u32 box_width_out, const u32 box_heig
     box->wall_clr = box_wall_clr;
     box->interior_clr = box_interior_clr;
 
-    box->BL_out.x = (world->width - box->width_out) / 2;
-    box->BL_out.y = (world->height - box->height_out - text_panel_height) / 3;
+    box->BL_out.x = BL_out.x;
+    box->BL_out.y = BL_out.y;
     
     box->width_in = box->width_out - 2 * box->wall_width;
     box->height_in = box->height_out - box->wall_width;
@@ -122,104 +218,1151 @@ box_init(Box_t *box, World_t *world, const u32 box_width_out, const u32 box_heig
     /* Initialization of non-constant fields */
     box->packed_circles_num = 0;
     box->occupied_fraction = 0.0f;
+    box->radiuses_sq_sum = 0;
 
-    /* Calculate the parameters of the each block */
-    box_calc_blocks_params(box);
+    /* Release all the packed circle objects and the records of the cells */
+    arena_reset(box->arena);
 
-    /* Clear all the packed circle objects */
-    circles_list_empty(box->circles_list, 1);
+    /* Allocate the grid cells (or the quadtree root) or clear their possible contents */
+    assert(((u64)box->UR_out.x << box->subpixel_bits < (1u << 30)) &&
+           ((u64)box->UR_out.y << box->subpixel_bits < (1u << 30)));
+    if (box->index_type == BOX_INDEX_QUADTREE) {
+        quadtree_init(box->quadtree, box->BL_in.x << box->subpixel_bits, box->BL_in.y << box->subpixel_bits,
+                      box->width_in << box->subpixel_bits, box->height_in << box->subpixel_bits,
+                      BOX_QUADTREE_MIN_HALF << box->subpixel_bits);
+    }
+    else {
+        box_cells_init(box);
+    }
 
-    /* Clear the possible contents of the box blocks */
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        for (j = 0; j < box->blocks_side_num; ++j) {
-            circles_list_empty(box->blocks[i][j].circles_list, 0);
+    /* Clearance of the empty box is limited by the walls and the floor only */
+    box_clearance_init(box);
+    box_skyline_init(box);
+
+    /* Reset the candidates of the contact engine for the empty box */
+    if (NULL != box->contact_engine) {
+        contact_engine_init(box->contact_engine, box);
+    }
+}
+
+void
+box_set_subpixel(Box_t *box, const b32 is_subpixel)
+{
+    /* Method to set the sub-pixel mode. The circles centers, the records and the lanes of the
+       index are kept in 1/2^BOX_SUBPIXEL_BITS pix, so the placement is not snapped to the pixels.
+       The clearance raster and the skyline stay in pix: they are exact for the centers in the
+       pixels and give the bounds for the others. Should be set before the box initialization */
+    box->subpixel_bits = is_subpixel ? BOX_SUBPIXEL_BITS : 0;
+}
+
+void
+box_set_contact_engine(Box_t *box, Contact_engine_t *contact_engine)
+{
+    /* Method to set the contact engine. It is updated by every added circle and deleted with the
+       box. Should be set before the box initialization */
+    if (NULL != box->contact_engine) {
+        contact_engine_delete(box->contact_engine);
+    }
+    box->contact_engine = contact_engine;
+}
+
+static void
+box_cells_init(Box_t *box)
+{
+    /* Function for the allocation of the blocks array of the grid cells covering the possible
+       circle centers of the interior. The array is reallocated if the box size has changed,
+       otherwise it is only cleared: the blocks with their records and lanes were in the box arena,
+       which is already reset. Every block keeps BOX_CELL_BLOCK_SIDE^2 cells, so the reset does
+       not depend on the number of the packed circles and the empty parts of the box take only the
+       pointers */
+
+    u32 cells_x_num, cells_y_num, blocks_x_num, blocks_y_num;
+
+    cells_x_num = box->width_in / box->cell_side + 1;
+    cells_y_num = box->height_in / box->cell_side + 1;
+    blocks_x_num = (cells_x_num + BOX_CELL_BLOCK_SIDE - 1) / BOX_CELL_BLOCK_SIDE;
+    blocks_y_num = (cells_y_num + BOX_CELL_BLOCK_SIDE - 1) / BOX_CELL_BLOCK_SIDE;
+    box->cells_x_num = cells_x_num;
+    box->cells_y_num = cells_y_num;
+
+    if ((NULL == box->cell_blocks) || (blocks_x_num != box->cell_blocks_x_num) ||
+        (blocks_y_num != box->cell_blocks_y_num)) {
+        free(box->cell_blocks);
+        box->cell_blocks_x_num = blocks_x_num;
+        box->cell_blocks_y_num = blocks_y_num;
+        box->cell_blocks = (Box_cell_t **) calloc ((size_t)blocks_x_num * blocks_y_num, sizeof(Box_cell_t *));
+        if (NULL == box->cell_blocks) print_error_and_exit("Error in memory allocation!\n");
+    }
+    else {
+        memset(box->cell_blocks, 0, (size_t)blocks_x_num * blocks_y_num * sizeof(Box_cell_t *));
+    }
+}
+
+static Box_cell_t*
+box_cell_at(const Box_t *box, const u32 cx, const u32 cy)
+{
+    /* Function to get the grid cell (cx, cy). Returns NULL if no circle is centered in its block */
+
+    Box_cell_t *block;
+
+    block = box->cell_blocks[(size_t)(cy / BOX_CELL_BLOCK_SIDE) * box->cell_blocks_x_num + cx / BOX_CELL_BLOCK_SIDE];
+    if (NULL == block) {
+        return NULL;
+    }
+    return &block[(cy % BOX_CELL_BLOCK_SIDE) * BOX_CELL_BLOCK_SIDE + cx % BOX_CELL_BLOCK_SIDE];
+}
+
+static Box_cell_t*
+box_cell_get(Box_t *box, const u32 cx, const u32 cy)
+{
+    /* Function to get the grid cell (cx, cy) for the new circle. The block of the cell is allocated
+       in the box arena (with the empty cells) by the first circle centered in it */
+
+    Box_cell_t **block;
+
+    block = &box->cell_blocks[(size_t)(cy / BOX_CELL_BLOCK_SIDE) * box->cell_blocks_x_num + cx / BOX_CELL_BLOCK_SIDE];
+    if (NULL == *block) {
+        *block = (Box_cell_t *) arena_alloc(box->arena, BOX_CELL_BLOCK_SIDE * BOX_CELL_BLOCK_SIDE * sizeof(Box_cell_t),
+                                            sizeof(void *));
+        memset(*block, 0, BOX_CELL_BLOCK_SIDE * BOX_CELL_BLOCK_SIDE * sizeof(Box_cell_t));
+    }
+    return &(*block)[(cy % BOX_CELL_BLOCK_SIDE) * BOX_CELL_BLOCK_SIDE + cx % BOX_CELL_BLOCK_SIDE];
+}
+
+static void
+box_cell_of(const Box_t *box, const u32 x, const u32 y, u32 *cx, u32 *cy)
+{
+    /* Function to get the grid cell of the pixel of the circle center (x, y) in the geometry units
+       (arithmetically, the center is always inside the interior) */
+    *cx = ((x >> box->subpixel_bits) - box->BL_in.x) / box->cell_side;
+    *cy = ((y >> box->subpixel_bits) - box->BL_in.y) / box->cell_side;
+    if (*cx >= box->cells_x_num) *cx = box->cells_x_num - 1;
+    if (*cy >= box->cells_y_num) *cy = box->cells_y_num - 1;
+}
+
+static void
+box_cell_reserve(Box_t *box, Box_cell_t *cell, const u32 capacity)
+{
+    /* Function to move the records array and the lanes of the cell to the new arrays of the
+       capacity (multiple of OVERLAP_LANE_WIDTH). The new arrays are taken from the box arena (the
+       old ones are released with the arena reset, so with the doubling capacity the wasted memory
+       is less than the used one). The lanes are aligned for the SIMD loads and the new elements
+       are filled by the far padding, so the overlap kernels process the whole blocks of 8 circles */
+
+    u32 k;
+    Circle_record_t *records;
+    s32 *xs, *ys, *rs;
+
+    records = (Circle_record_t *) arena_alloc(box->arena, capacity * sizeof(Circle_record_t),
+                                              sizeof(u32));
+    xs = (s32 *) arena_alloc(box->arena, capacity * sizeof(s32), BOX_LANE_ALIGNMENT);
+    ys = (s32 *) arena_alloc(box->arena, capacity * sizeof(s32), BOX_LANE_ALIGNMENT);
+    rs = (s32 *) arena_alloc(box->arena, capacity * sizeof(s32), BOX_LANE_ALIGNMENT);
+    for (k = 0; k < capacity; ++k) {
+        if (k < cell->records_num) {
+            records[k] = cell->records[k];
+            xs[k] = cell->xs[k];
+            ys[k] = cell->ys[k];
+            rs[k] = cell->rs[k];
+        }
+        else {
+            xs[k] = OVERLAP_FAR_COORDINATE;
+            ys[k] = OVERLAP_FAR_COORDINATE;
+            rs[k] = 0;
         }
     }
+    cell->records = records;
+    cell->xs = xs;
+    cell->ys = ys;
+    cell->rs = rs;
+    cell->records_capacity = capacity;
 }
 
 static void
-box_calc_blocks_params(Box_t *box)
-{
-    /* Function for calculation of the blocks parameters like coordinates of the BL point, 
-       width and height */
-       
-    u32 i, j;
-    u32 block_width_length; /* Length of the block width */
-    u32 block_height_length; /* Length of the block height */
-
-    /* Calculate the blocks side length */
-    block_width_length = (u32)roundf((f32)box->width_in / (f32)box->blocks_side_num);
-    block_height_length = (u32)roundf((f32)box->height_in / (f32)box->blocks_side_num);
+box_cells_build(Box_t *box, const Circle_record_t *records, const u32 records_num)
+{
+    /* Function for the bulk placement of the records into the empty grid. The first pass counts
+       the records of every cell, then the arrays of every used cell are taken from the arena once
+       and the second pass fills them */
+
+    u32 i, k, cx, cy, capacity;
+    size_t b;
+    Box_cell_t *cell;
+    Box_cell_t *block;
+
+    for (i = 0; i < records_num; ++i) {
+        box_cell_of(box, records[i].x, records[i].y, &cx, &cy);
+        box_cell_get(box, cx, cy)->records_num += 1;
+    }
+
+    for (b = 0; b < (size_t)box->cell_blocks_x_num * box->cell_blocks_y_num; ++b) {
+        block = box->cell_blocks[b];
+        for (k = 0; (NULL != block) && (k < BOX_CELL_BLOCK_SIDE * BOX_CELL_BLOCK_SIDE); ++k) {
+            cell = &block[k];
+            if (cell->records_num > 0) {
+                /* Capacity is rounded up to the whole blocks of the lanes (at least the initial one) */
+                capacity = (cell->records_num + OVERLAP_LANE_WIDTH - 1) / OVERLAP_LANE_WIDTH * OVERLAP_LANE_WIDTH;
+                if (capacity < 16) capacity = 16;
+                cell->records_num = 0;
+                box_cell_reserve(box, cell, capacity);
+            }
+        }
+    }
+
+    for (i = 0; i < records_num; ++i) {
+        box_cell_of(box, records[i].x, records[i].y, &cx, &cy);
+        cell = box_cell_at(box, cx, cy);
+        cell->records[cell->records_num] = records[i];
+        cell->xs[cell->records_num] = (s32)records[i].x;
+        cell->ys[cell->records_num] = (s32)records[i].y;
+        cell->rs[cell->records_num] = (s32)records[i].radius;
+        cell->records_num += 1;
+    }
+}
+
+void
+box_cells_range(const Box_t *box, const u32 x0, const u32 y0, const u32 reach, u32 *cx_begin,
+                u32 *cx_end, u32 *cy_begin, u32 *cy_end)
+{
+    /* Method to calculate the range of the grid cells (inclusive) where the centers within the
+       reach from (x0, y0) along both axes can be stored. The range is clipped by the grid */
+
+    u32 x, y;
+
+    x = (x0 > box->BL_in.x) ? x0 - box->BL_in.x : 0;
+    y = (y0 > box->BL_in.y) ? y0 - box->BL_in.y : 0;
+
+    *cx_begin = (x > reach) ? (x - reach) / box->cell_side : 0;
+    *cy_begin = (y > reach) ? (y - reach) / box->cell_side : 0;
+    *cx_end = (x + reach) / box->cell_side;
+    *cy_end = (y + reach) / box->cell_side;
+    if (*cx_end >= box->cells_x_num) *cx_end = box->cells_x_num - 1;
+    if (*cy_end >= box->cells_y_num) *cy_end = box->cells_y_num - 1;
+}
+
+Circle_t*
+box_add_circle(Box_t *box, const V2_u32_t center, const u32 radius, const u32 color)
+{
+    /* Method for adding new circle with the center at the pixel */
+
+    V2_u32_t position;
+
+    position.x = center.x << box->subpixel_bits;
+    position.y = center.y << box->subpixel_bits;
+    return box_add_circle_at(box, position, radius, color);
+}
+
+Circle_t*
+box_add_circle_at(Box_t *box, const V2_u32_t position, const u32 radius, const u32 color)
+{
+    /* Method for adding new circle to the spatial index (to the grid cell of its center or to the
+       quadtree node of its center and size). The center is in the geometry units. The circle
+       object is allocated in the box arena */
     
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        for (j = 0; j < box->blocks_side_num; ++j) {
-            
-            /* Calculate the BL coordinates of the blocks */
-            box->blocks[i][j].BL.x = box->BL_in.x + i * block_width_length;
-            box->blocks[i][j].BL.y = box->BL_in.y + j * block_height_length;
-            
-            /* Calculate the width of the blocks */
-            if (i == (box->blocks_side_num - 1)) {
-                /* Special case for the last block in block columns */
-                box->blocks[i][j].width = box->width_in - block_width_length * (box->blocks_side_num - 1);
+    u32 cx, cy;
+    Box_cell_t *cell;
+    Circle_record_t record;
+
+    record.x = position.x;
+    record.y = position.y;
+    record.radius = radius << box->subpixel_bits;
+    record.index = box->packed_circles_num;
+
+    if (box->index_type == BOX_INDEX_QUADTREE) {
+        quadtree_insert(box->quadtree, &record);
+        return box_add_circle_finish(box, &record, color);
+    }
+
+    /* Circles larger than max_radius are not found by the 3x3 queries */
+    assert(radius <= box->max_radius);
+
+    box_cell_of(box, position.x, position.y, &cx, &cy);
+    cell = box_cell_get(box, cx, cy);
+
+    /* Add the circle record and its lanes elements to the cell (arrays grow twice) */
+    if (cell->records_num == cell->records_capacity) {
+        box_cell_reserve(box, cell, (cell->records_capacity > 0) ? 2 * cell->records_capacity : 16);
+    }
+    cell->records[cell->records_num] = record;
+    cell->xs[cell->records_num] = (s32)record.x;
+    cell->ys[cell->records_num] = (s32)record.y;
+    cell->rs[cell->records_num] = (s32)record.radius;
+    cell->records_num += 1;
+
+    return box_add_circle_finish(box, &record, color);
+}
+
+void
+box_restore(Box_t *box, const V2_u32_t *positions, const u32 *radiuses, const u32 *colors,
+            const u32 circles_num)
+{
+    /* Method to restore the packed circles in the empty initialized box (the centers are in the
+       geometry units). The spatial index is built in one pass over all the circles, instead of the
+       growth of the cells (or the quadtree nodes) by the separate additions. The candidates of the
+       contact engine are not updated (they are restored by the engine) */
+
+    u32 i;
+    Circle_record_t *records;
+    Circle_t *circle;
+
+    assert(0 == box->packed_circles_num);
+    if (0 == circles_num) {
+        return;
+    }
+
+    records = (Circle_record_t *) calloc (circles_num, sizeof(Circle_record_t));
+    if (NULL == records) print_error_and_exit("Error in memory allocation!\n");
+
+    for (i = 0; i < circles_num; ++i) {
+        records[i].x = positions[i].x;
+        records[i].y = positions[i].y;
+        records[i].radius = radiuses[i] << box->subpixel_bits;
+        records[i].index = i;
+        assert((box->index_type == BOX_INDEX_QUADTREE) || (radiuses[i] <= box->max_radius));
+    }
+
+    if (box->index_type == BOX_INDEX_QUADTREE) {
+        quadtree_build(box->quadtree, records, circles_num);
+    }
+    else {
+        box_cells_build(box, records, circles_num);
+    }
+
+    for (i = 0; i < circles_num; ++i) {
+        circle = box_circle_create(box, &records[i], colors[i]);
+        box_clearance_add_circle(box, circle);
+        box_skyline_add_circle(box, circle);
+    }
+
+    free(records);
+}
+
+static Circle_t*
+box_circle_create(Box_t *box, const Circle_record_t *record, const u32 color)
+{
+    /* Function to create the circle object of the record in the box arena and to append it to the
+       array of the packed circles */
+
+    Circle_t *circle;
+    Circle_t **tmp_circles;
+
+    circle = (Circle_t *) arena_alloc(box->arena, sizeof(Circle_t), sizeof(u32));
+    circle->position.x = record->x;
+    circle->position.y = record->y;
+    circle->center.x = (record->x + ((1u << box->subpixel_bits) >> 1)) >> box->subpixel_bits;
+    circle->center.y = (record->y + ((1u << box->subpixel_bits) >> 1)) >> box->subpixel_bits;
+    circle->radius = record->radius >> box->subpixel_bits;
+    circle->color = color;
+
+    if (box->packed_circles_num == box->circles_capacity) {
+        box->circles_capacity = (box->circles_capacity > 0) ? 2 * box->circles_capacity : 1024;
+        tmp_circles = (Circle_t **) realloc (box->circles, box->circles_capacity * sizeof(Circle_t *));
+        if (NULL == tmp_circles) print_error_and_exit("Error in memory allocation!\n");
+        box->circles = tmp_circles;
+    }
+    box->circles[box->packed_circles_num] = circle;
+    box->packed_circles_num += 1;
+
+    /* Area is summed in the integers, so the fraction does not drift with the number of circles */
+    box->radiuses_sq_sum += (u64)circle->radius * circle->radius;
+    box->occupied_fraction = (f32)(M_PI * (f64)box->radiuses_sq_sum / ((f64)box->width_in * (f64)box->height_in));
+
+    return circle;
+}
+
+static Circle_t*
+box_add_circle_finish(Box_t *box, const Circle_record_t *record, const u32 color)
+{
+    /* Function to create the circle object and to update the box data after the circle has been
+       added to the spatial index */
+
+    Circle_t *circle;
+
+    circle = box_circle_create(box, record, color);
+    box_clearance_add_circle(box, circle);
+    box_skyline_add_circle(box, circle);
+
+    /* Update the candidates of the contact placement */
+    if (NULL != box->contact_engine) {
+        contact_engine_add_circle(box->contact_engine, box, circle);
+    }
+
+    return circle;
+}
+
+static void
+box_clearance_init(Box_t *box)
+{
+    /* Function for the initialization of the clearance raster of the empty box. The raster keeps
+       for every possible center pixel the largest radius (up to max_radius) of the circle fitting
+       between the walls and the floor. In the empty box it is known analytically, so only the
+       maximums of the tiles are calculated and the pixels of the tile are allocated by the first
+       circle near it. The tiles able to hold the smallest circle are put into the list of the open
+       tiles. The tiles arrays are reallocated if the box size has changed */
+
+    u32 i, tile_x, tile_y, value, value_y;
+    u32 width, height;
+    size_t tiles_num;
+
+    /* Number of the tiles is below BOX_MAX_TILES_NUM (checked by box_init), so the tile indices
+       fit u32, but the product is still taken in size_t */
+    width = box->width_in + 1;
+    height = box->height_in + 1;
+    tiles_num = (size_t)((width + BOX_TILE_SIDE - 1) / BOX_TILE_SIDE) * ((height + BOX_TILE_SIDE - 1) / BOX_TILE_SIDE);
+    if ((NULL == box->clearance) || (width != box->clearance_width) || (height != box->clearance_height)) {
+        free(box->clearance);
+        free(box->clearance_tiles);
+        free(box->open_tiles);
+        free(box->open_tile_slots);
+        box->clearance_width = width;
+        box->clearance_height = height;
+        box->tiles_x_num = (width + BOX_TILE_SIDE - 1) / BOX_TILE_SIDE;
+        box->tiles_y_num = (height + BOX_TILE_SIDE - 1) / BOX_TILE_SIDE;
+        box->clearance = (u16 **) calloc (tiles_num, sizeof(u16 *));
+        box->clearance_tiles = (u16 *) calloc (tiles_num, sizeof(u16));
+        box->open_tiles = (u32 *) calloc (tiles_num, sizeof(u32));
+        box->open_tile_slots = (u32 *) calloc (tiles_num, sizeof(u32));
+        if ((NULL == box->clearance) || (NULL == box->clearance_tiles) || (NULL == box->open_tiles) ||
+            (NULL == box->open_tile_slots)) {
+            print_error_and_exit("Error in memory allocation!\n");
+        }
+    }
+    else {
+        /* Pixels of the tiles were in the box arena, which is already reset */
+        memset(box->clearance, 0, tiles_num * sizeof(u16 *));
+    }
+    box->free_clearance = NULL;
+    memset(box->clearance_counts, 0, (box->max_radius + 1) * sizeof(u32));
+
+    /* Clearance limited by the walls is the minimum of the limits along x and y, so the maximum of
+       the tile is the minimum of the maximums along its sides */
+    box->open_tiles_num = 0;
+    for (tile_y = 0; tile_y < box->tiles_y_num; ++tile_y) {
+        value_y = box_clearance_wall_max(height, tile_y * BOX_TILE_SIDE, (tile_y + 1) * BOX_TILE_SIDE,
+                                         box->max_radius);
+        for (tile_x = 0; tile_x < box->tiles_x_num; ++tile_x) {
+            value = box_clearance_wall_max(width, tile_x * BOX_TILE_SIDE, (tile_x + 1) * BOX_TILE_SIDE, value_y);
+            i = tile_y * box->tiles_x_num + tile_x;
+            box->clearance_tiles[i] = (u16)value;
+            box->clearance_counts[value] += 1;
+            if (value >= box->min_radius) {
+                box->open_tile_slots[i] = box->open_tiles_num;
+                box->open_tiles[box->open_tiles_num] = i;
+                box->open_tiles_num += 1;
             }
             else {
-                /* Normal block */
-                box->blocks[i][j].width = block_width_length;
+                box->open_tile_slots[i] = BOX_TILE_CLOSED;
             }
+        }
+    }
+}
+
+static u32
+box_clearance_wall(const Box_t *box, const u32 x, const u32 y)
+{
+    /* Function to get the clearance of the raster pixel (x, y) limited by the left and right walls,
+       the floor and the top of the box */
+
+    u32 value;
+
+    value = box->max_radius;
+    if (x < value) value = x;
+    if (box->clearance_width - 1 - x < value) value = box->clearance_width - 1 - x;
+    if (y < value) value = y;
+    if (box->clearance_height - 1 - y < value) value = box->clearance_height - 1 - y;
+    return value;
+}
+
+static u32
+box_clearance_wall_max(const u32 size, const u32 begin, const u32 end, const u32 cap)
+{
+    /* Function to get the largest value of min(v, size - 1 - v, cap) for v in [begin, end) clipped
+       by the size. The function grows till the middle of the size, so its largest value is at the
+       pixel of the range closest to the middle */
 
-            /* Calculate the height of the block */
-            if (j == (box->blocks_side_num - 1)) {
-                /* Special case for the last block in block rows */
-                box->blocks[i][j].height = box->height_in - block_height_length * (box->blocks_side_num - 1);
+    u32 v, value;
+
+    v = (size - 1) / 2;
+    if (v < begin) v = begin;
+    if ((end < size) && (v > end - 1)) v = end - 1;
+
+    value = cap;
+    if (v < value) value = v;
+    if (size - 1 - v < value) value = size - 1 - v;
+    return value;
+}
+
+static u16*
+box_clearance_pixels(Box_t *box, const u32 tile_x, const u32 tile_y)
+{
+    /* Function to get the pixels of the open tile. The first call takes the released pixels of
+       the saturated tile (or allocates them in the box arena) and fills them by the clearance
+       limited by the walls. Pixels outside of the raster are zero */
+
+    u32 i, x, y, x0, y0;
+    u16 *pixels;
+
+    i = tile_y * box->tiles_x_num + tile_x;
+    if (NULL != box->clearance[i]) {
+        return box->clearance[i];
+    }
+
+    if (NULL != box->free_clearance) {
+        pixels = box->free_clearance;
+        memcpy(&box->free_clearance, pixels, sizeof(u16 *));
+    }
+    else {
+        pixels = (u16 *) arena_alloc(box->arena, BOX_TILE_SIDE * BOX_TILE_SIDE * sizeof(u16), BOX_LANE_ALIGNMENT);
+    }
+
+    x0 = tile_x * BOX_TILE_SIDE;
+    y0 = tile_y * BOX_TILE_SIDE;
+    for (y = 0; y < BOX_TILE_SIDE; ++y) {
+        for (x = 0; x < BOX_TILE_SIDE; ++x) {
+            if ((x0 + x < box->clearance_width) && (y0 + y < box->clearance_height)) {
+                pixels[y * BOX_TILE_SIDE + x] = (u16)box_clearance_wall(box, x0 + x, y0 + y);
             }
             else {
-                /* Normal block */
-                box->blocks[i][j].height = block_height_length;
+                pixels[y * BOX_TILE_SIDE + x] = 0;
+            }
+        }
+    }
+    box->clearance[i] = pixels;
+    return pixels;
+}
+
+static b32
+box_clearance_get(const Box_t *box, const u32 x, const u32 y, u32 *value)
+{
+    /* Function to get the clearance of the raster pixel (x, y). The values of the saturated tiles
+       are not kept (they are below min_radius), then false is returned */
+
+    u32 i;
+    const u16 *pixels;
+
+    i = (y / BOX_TILE_SIDE) * box->tiles_x_num + x / BOX_TILE_SIDE;
+    if (box->open_tile_slots[i] == BOX_TILE_CLOSED) {
+        return false;
+    }
+    pixels = box->clearance[i];
+    if (NULL == pixels) {
+        *value = box_clearance_wall(box, x, y);
+    }
+    else {
+        *value = pixels[(y % BOX_TILE_SIDE) * BOX_TILE_SIDE + x % BOX_TILE_SIDE];
+    }
+    return true;
+}
+
+static void
+box_clearance_add_circle(Box_t *box, const Circle_t *circle)
+{
+    /* Function for the update of the clearance raster in the footprint of the added circle. The
+       circle of radius r at the distance d is feasible if (r + r1)^2 < d^2 (touching circles are
+       intercepting), so the largest radius is isqrt(d^2 - 1) - r1. In the sub-pixel mode d is in
+       the geometry units, then the largest radius is isqrt(d^2 - 1) / 2^bits - r1 (in pix). Only
+       the pixels closer than r1 + max_radius + 1 can be changed. The footprint is updated tile by
+       tile, the saturated tiles are skipped and the maximum is recalculated only if the pixel with
+       it was lowered */
+
+    s32 cx, cy, cx_end, cy_end, reach;
+    s32 x_begin, x_end, y_begin, y_end, x, y;
+    s32 tx_begin, tx_end, ty_begin, ty_end;
+    s64 cx_units, cy_units, dx, dy;
+    u64 d2;
+    u32 s, value, tile_max;
+    u32 bits = box->subpixel_bits;
+    u32 i, tile_x, tile_y;
+    b32 is_max_lowered;
+    u16 *pixels, *row;
+
+    if (NULL == box->clearance) {
+        return;
+    }
+
+    /* Center of the circle in the raster coordinates (in the geometry units and the pixels around) */
+    cx_units = (s64)circle->position.x - ((s64)box->BL_in.x << bits);
+    cy_units = (s64)circle->position.y - ((s64)box->BL_in.y << bits);
+    cx = (s32)(cx_units >> bits);
+    cy = (s32)(cy_units >> bits);
+    cx_end = (s32)((cx_units + (1 << bits) - 1) >> bits);
+    cy_end = (s32)((cy_units + (1 << bits) - 1) >> bits);
+    reach = (s32)(circle->radius + box->max_radius + 1);
+
+    x_begin = (cx - reach < 0) ? 0 : cx - reach;
+    y_begin = (cy - reach < 0) ? 0 : cy - reach;
+    x_end = (cx_end + reach > (s32)box->clearance_width - 1) ? (s32)box->clearance_width - 1 : cx_end + reach;
+    y_end = (cy_end + reach > (s32)box->clearance_height - 1) ? (s32)box->clearance_height - 1 : cy_end + reach;
+    if ((x_begin > x_end) || (y_begin > y_end)) {
+        return;
+    }
+
+    for (tile_y = (u32)y_begin / BOX_TILE_SIDE; tile_y <= (u32)y_end / BOX_TILE_SIDE; ++tile_y) {
+        for (tile_x = (u32)x_begin / BOX_TILE_SIDE; tile_x <= (u32)x_end / BOX_TILE_SIDE; ++tile_x) {
+            i = tile_y * box->tiles_x_num + tile_x;
+            if (box->open_tile_slots[i] == BOX_TILE_CLOSED) {
+                continue;
             }
+            pixels = box_clearance_pixels(box, tile_x, tile_y);
+            tile_max = box->clearance_tiles[i];
+            is_max_lowered = false;
+
+            /* Part of the footprint in the tile (in the tile coordinates) */
+            tx_begin = (x_begin > (s32)(tile_x * BOX_TILE_SIDE)) ? x_begin - (s32)(tile_x * BOX_TILE_SIDE) : 0;
+            ty_begin = (y_begin > (s32)(tile_y * BOX_TILE_SIDE)) ? y_begin - (s32)(tile_y * BOX_TILE_SIDE) : 0;
+            tx_end = x_end - (s32)(tile_x * BOX_TILE_SIDE);
+            ty_end = y_end - (s32)(tile_y * BOX_TILE_SIDE);
+            if (tx_end > BOX_TILE_SIDE - 1) tx_end = BOX_TILE_SIDE - 1;
+            if (ty_end > BOX_TILE_SIDE - 1) ty_end = BOX_TILE_SIDE - 1;
 
-            /* Calculate the UR coordinates of the block */
-            box->blocks[i][j].UR.x = box->blocks[i][j].BL.x + block_width_length;
-            box->blocks[i][j].UR.y = box->blocks[i][j].BL.y + block_height_length;
+            for (y = ty_begin; y <= ty_end; ++y) {
+                row = pixels + y * BOX_TILE_SIDE;
+                dy = ((s64)(y + (s32)(tile_y * BOX_TILE_SIDE)) << bits) - cy_units;
+                for (x = tx_begin; x <= tx_end; ++x) {
+                    dx = ((s64)(x + (s32)(tile_x * BOX_TILE_SIDE)) << bits) - cx_units;
+                    d2 = (u64)(dx * dx + dy * dy);
+                    value = 0;
+                    if (d2 > 0) {
+                        s = (d2 <= 0xffffffffu) ? isqrt_u32((u32)(d2 - 1)) >> bits : (u32)(isqrt_u64(d2 - 1) >> bits);
+                        value = (s > circle->radius) ? s - circle->radius : 0;
+                    }
+                    if (value < row[x]) {
+                        if (row[x] == tile_max) is_max_lowered = true;
+                        row[x] = (u16)value;
+                    }
+                }
+            }
+
+            if (is_max_lowered) {
+                box_clearance_update_tile(box, tile_x, tile_y);
+            }
         }
-    }   
+    }
+}
+
+static void
+box_clearance_update_tile(Box_t *box, const u32 tile_x, const u32 tile_y)
+{
+    /* Function for the update of the maximum clearance of the open tile with the pixels. The
+       clearance never grows, so the tile becomes saturated only once: it is removed from the list
+       of the open tiles (the last open tile takes its slot) and its pixels are released for the
+       next tiles */
+
+    u32 x, y, x_end, y_end;
+    u32 i, slot, last;
+    u16 value, *row, *pixels;
+
+    i = tile_y * box->tiles_x_num + tile_x;
+    pixels = box->clearance[i];
+    x_end = box->clearance_width - tile_x * BOX_TILE_SIDE;
+    y_end = box->clearance_height - tile_y * BOX_TILE_SIDE;
+    if (x_end > BOX_TILE_SIDE) x_end = BOX_TILE_SIDE;
+    if (y_end > BOX_TILE_SIDE) y_end = BOX_TILE_SIDE;
+
+    value = 0;
+    for (y = 0; y < y_end; ++y) {
+        row = pixels + y * BOX_TILE_SIDE;
+        for (x = 0; x < x_end; ++x) {
+            if (row[x] > value) value = row[x];
+        }
+    }
+    box->clearance_counts[box->clearance_tiles[i]] -= 1;
+    box->clearance_counts[value] += 1;
+    box->clearance_tiles[i] = value;
+
+    slot = box->open_tile_slots[i];
+    if ((slot != BOX_TILE_CLOSED) && (value < box->min_radius)) {
+        last = box->open_tiles[box->open_tiles_num - 1];
+        box->open_tiles[slot] = last;
+        box->open_tile_slots[last] = slot;
+        box->open_tile_slots[i] = BOX_TILE_CLOSED;
+        box->open_tiles_num -= 1;
+
+        memcpy(pixels, &box->free_clearance, sizeof(u16 *));
+        box->free_clearance = pixels;
+        box->clearance[i] = NULL;
+    }
+}
+
+static void
+box_skyline_init(Box_t *box)
+{
+    /* Function for the initialization of the skyline of the empty box (all the columns are empty).
+       The skyline is reallocated if the box width has changed */
+
+    u32 columns_num;
+
+    columns_num = box->width_in / BOX_SKYLINE_COLUMN + 1;
+    if ((NULL == box->skyline) || (columns_num != box->skyline_columns_num)) {
+        free(box->skyline);
+        box->skyline_columns_num = columns_num;
+        box->skyline = (u32 *) calloc (columns_num, sizeof(u32));
+        if (NULL == box->skyline) print_error_and_exit("Error in memory allocation!\n");
+    }
+    else {
+        memset(box->skyline, 0, columns_num * sizeof(u32));
+    }
+}
+
+static void
+box_skyline_add_circle(Box_t *box, const Circle_t *circle)
+{
+    /* Function for the update of the skyline columns covered by the bounding square of the added
+       circle. The height of the column is the row above the highest occupied one (in the sub-pixel
+       mode the square is expanded to the pixels) */
+
+    u32 c, c_begin, c_end, x_begin, x_end, height;
+    u32 bits = box->subpixel_bits;
+
+    if (NULL == box->skyline) {
+        return;
+    }
+
+    x_begin = ((circle->position.x - (circle->radius << bits)) >> bits) - box->BL_in.x;
+    x_end = ((circle->position.x + (circle->radius << bits) + (1u << bits) - 1) >> bits) - box->BL_in.x;
+    c_begin = x_begin / BOX_SKYLINE_COLUMN;
+    c_end = x_end / BOX_SKYLINE_COLUMN;
+    if (c_end >= box->skyline_columns_num) c_end = box->skyline_columns_num - 1;
+
+    height = ((circle->position.y + (circle->radius << bits)) >> bits) + 1 - box->BL_in.y;
+    for (c = c_begin; c <= c_end; ++c) {
+        if (height > box->skyline[c]) box->skyline[c] = height;
+    }
+}
+
+u32
+box_surface_y(const Box_t *box, const u32 x0, const u32 radius)
+{
+    /* Method to get the lowest y of the bottom of the circle centered at the column x0 which is above
+       the skyline. The bounding squares of the intercepting (or touching) circles overlap, so the
+       circle with the bottom not lower than the heights of all the columns under it is feasible */
+
+    u32 c, c_begin, c_end, x, height;
+
+    if (NULL == box->skyline) {
+        return box->BL_in.y;
+    }
+
+    x = (x0 > box->BL_in.x) ? x0 - box->BL_in.x : 0;
+    c_begin = (x > radius) ? (x - radius) / BOX_SKYLINE_COLUMN : 0;
+    c_end = (x + radius) / BOX_SKYLINE_COLUMN;
+    if (c_end >= box->skyline_columns_num) c_end = box->skyline_columns_num - 1;
+
+    height = 0;
+    for (c = c_begin; c <= c_end; ++c) {
+        if (box->skyline[c] > height) height = box->skyline[c];
+    }
+    return box->BL_in.y + height;
+}
+
+b32
+box_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius)
+{
+    /* Method to check that the circle with the center at the pixel (x0, y0) does not intercept the
+       packed circles (the walls are not checked). For the radius up to max_radius this is one
+       lookup in the clearance raster, otherwise the circles of the box cells are checked. Function
+       does not modify any data, so it can be called from several threads */
+
+    V2_u32_t position;
+
+    position.x = x0 << box->subpixel_bits;
+    position.y = y0 << box->subpixel_bits;
+    return box_is_feasible_at(box, position, radius);
+}
+
+b32
+box_is_feasible_at(const Box_t *box, const V2_u32_t position, const u32 radius)
+{
+    /* Method to check that the circle with the center at the position in the geometry units does
+       not intercept the packed circles (the walls are not checked). The centers between the pixels
+       are resolved by the clearance raster only far from the limits, otherwise the circles of the
+       index are checked. Function does not modify any data */
+
+    switch (box_clearance_test(box, position.x, position.y, radius)) {
+    case BOX_TEST_FEASIBLE:
+        return true;
+    case BOX_TEST_INFEASIBLE:
+        return false;
+    default:
+        return box_scan_is_feasible(box, position.x, position.y, radius);
+    }
+}
+
+static Box_test_t
+box_clearance_test(const Box_t *box, const u32 x0, const u32 y0, const u32 radius)
+{
+    /* Function to test the circle center (in the geometry units) by the clearance raster of the
+       nearest pixel. The center between the pixels is less than 1 pix from it, so the margin of 1
+       pix is taken. The clearance is also limited by the walls: far enough from them the clearance
+       below the radius (with the margin) means the interception, near them (or
+       without the raster) the circle above the skyline is accepted, otherwise the circles have to
+       be checked. Clearance of the saturated tile is below min_radius, so it is enough to reject
+       the circles larger than min_radius - 1 */
+
+    u32 x, y, value, bound, margin;
+    u32 bits = box->subpixel_bits;
+    b32 is_kept;
+
+    margin = (((x0 | y0) & ((1u << bits) - 1)) != 0) ? 1 : 0;
+    x = (x0 + ((1u << bits) >> 1)) >> bits;
+    y = (y0 + ((1u << bits) >> 1)) >> bits;
+
+    if ((radius <= box->max_radius) && (NULL != box->clearance) && (x >= box->BL_in.x) && (y >= box->BL_in.y)) {
+        x -= box->BL_in.x;
+        y -= box->BL_in.y;
+        if ((x < box->clearance_width) && (y < box->clearance_height)) {
+            is_kept = box_clearance_get(box, x, y, &value);
+            if (is_kept && (value >= radius + margin)) {
+                return BOX_TEST_FEASIBLE;
+            }
+            bound = is_kept ? value : box->min_radius - 1;
+            if ((radius >= bound + 1 + margin) && (x > bound) && (x + bound + 1 < box->clearance_width) &&
+                (y > bound) && (y + bound + 1 < box->clearance_height)) {
+                return BOX_TEST_INFEASIBLE;
+            }
+        }
+        x += box->BL_in.x;
+    }
+    if ((y0 >= radius << bits) &&
+        (y0 - (radius << bits) >= box_surface_y(box, x, radius + margin) << bits)) {
+        return BOX_TEST_FEASIBLE;
+    }
+    return BOX_TEST_SCAN;
+}
+
+f32
+box_center_cost(const Box_t *box, const u32 x0, const u32 y0)
+{
+    /* Method to calculate the cost of the circle center at the pixel (x0, y0) */
+
+    V2_u32_t position;
+
+    position.x = x0 << box->subpixel_bits;
+    position.y = y0 << box->subpixel_bits;
+    return box_position_cost(box, position);
+}
+
+f32
+box_position_cost(const Box_t *box, const V2_u32_t position)
+{
+    /* Method to calculate the cost of the circle center at the position in the geometry units:
+       distance to the middle bottom point of the box plus the distance to the bottom of the box
+       (lower and closer to the middle is better), in pix. The squared distance is exact integer,
+       the float is used only for its root */
+
+    s64 x1, y1; /* Coordinates (in the geometry units) of the middle bottom point of the box */
+    s64 dx, dy;
+    f32 scale;
+
+    x1 = (s64)((box->BL_in.x + box->BR_in.x) / 2) << box->subpixel_bits;
+    y1 = (s64)box->BL_in.y << box->subpixel_bits;
+    dx = (s64)position.x - x1;
+    dy = (s64)position.y - y1;
+    scale = 1.0f / (f32)(1u << box->subpixel_bits);
+
+    return (sqrtf((f32)(dx * dx + dy * dy)) + (f32)position.y) * scale;
+}
+
+V2_u32_t
+box_settle(const Box_t *box, const V2_u32_t position, const u32 radius)
+{
+    /* Method to close the gap left by the placement at the pixel: the feasible circle is moved down
+       (not below the floor) and then to the middle of the box by less than a pixel, so both moves
+       lower the cost. The largest feasible shift is found by the bisection of the geometry units
+       (BOX_SUBPIXEL_BITS checks per move). Does nothing without the sub-pixel mode */
+
+    V2_u32_t result, probe;
+    u32 lo, hi, mid, limit, middle, floor_y;
+    u32 bits = box->subpixel_bits;
+    b32 is_right;
+
+    result = position;
+    if (0 == bits) {
+        return result;
+    }
+
+    /* Move down */
+    floor_y = (box->BL_in.y + radius) << bits;
+    limit = (result.y > floor_y) ? result.y - floor_y : 0;
+    if (limit > (1u << bits) - 1) limit = (1u << bits) - 1;
+    lo = 0;
+    hi = limit + 1;
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        probe.x = result.x;
+        probe.y = result.y - mid;
+        if (box_is_feasible_at(box, probe, radius)) lo = mid;
+        else hi = mid;
+    }
+    result.y -= lo;
+
+    /* Move to the middle */
+    middle = ((box->BL_in.x + box->BR_in.x) / 2) << bits;
+    is_right = (result.x > middle);
+    limit = is_right ? result.x - middle : middle - result.x;
+    if (limit > (1u << bits) - 1) limit = (1u << bits) - 1;
+    lo = 0;
+    hi = limit + 1;
+    while (hi - lo > 1) {
+        mid = (lo + hi) / 2;
+        probe.x = is_right ? result.x - mid : result.x + mid;
+        probe.y = result.y;
+        if (box_is_feasible_at(box, probe, radius)) lo = mid;
+        else hi = mid;
+    }
+    result.x = is_right ? result.x - lo : result.x + lo;
+
+    return result;
 }
 
 void
-box_add_circle(Box_t *box, Circle_t *circle)
+box_query_batch(const Box_t *box, const u32 radius, const u32 n, const u32 *xs, const u32 *ys, f32 *costs,
+                b32 *is_feasible)
 {
-    /* Method for adding new circle to the corresponding box block */
-    
-    u32 i, j;
-    V2_u32_t block_BL, block_UR; /* BL and UR points of outside rectangle of the block */
-    V2_u32_t circ_BL, circ_UR; /* BL and UR points of outside rectangle of the circle */
+    /* Method to calculate the feasibility flags and the costs of n circle centers (xs[i], ys[i]) of
+       the radius in one pass (the centers are in the geometry units). Most of the centers are
+       resolved by the clearance raster, the rest is binned by the grid cell of the center, so the
+       circles of every cell are loaded once for all the candidates around it. Infeasible centers
+       get BOX_INFEASIBLE_COST. Function does not modify any data of the box, so it can be called
+       from several threads */
 
-    /* Determine the parameters of the outside rectangle of the circle */
-    circ_BL.x = circle->center.x - circle->radius;
-    circ_BL.y = circle->center.y - circle->radius;
-    circ_UR.x = circle->center.x + circle->radius;
-    circ_UR.y = circle->center.y + circle->radius;
+    u32 i, block, block_end;
+    u32 pending[BOX_BATCH_BLOCK]; /* Candidates needing the scan of the cells */
+    u32 pending_num;
+    V2_u32_t position;
 
-    /* Check every box block for the colision with circle outside rectangle */
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        for (j = 0; j < box->blocks_side_num; ++j) {
+    for (block = 0; block < n; block += BOX_BATCH_BLOCK) {
+        block_end = (block + BOX_BATCH_BLOCK < n) ? block + BOX_BATCH_BLOCK : n;
 
-            /* Determine the parameters of the outside rectangle of the current block */
-            block_BL.x = box->blocks[i][j].BL.x;
-            block_BL.y = box->blocks[i][j].BL.y;
-            block_UR.x = box->blocks[i][j].UR.x;
-            block_UR.y = box->blocks[i][j].UR.y;
+        pending_num = 0;
+        for (i = block; i < block_end; ++i) {
+            switch (box_clearance_test(box, xs[i], ys[i], radius)) {
+            case BOX_TEST_FEASIBLE:
+                is_feasible[i] = true;
+                break;
+            case BOX_TEST_INFEASIBLE:
+                is_feasible[i] = false;
+                break;
+            default:
+                is_feasible[i] = true;
+                pending[pending_num] = i;
+                pending_num += 1;
+                break;
+            }
+        }
 
-            /* Check the colision of the outside rectangles of block and circle */
-            if (rectangles_are_collide(block_BL, block_UR, circ_BL, circ_UR)) {
-                /* Add circle to the current box block */
-                circles_list_push(box->blocks[i][j].circles_list, circle);               
+        if (pending_num > 0) {
+            box_batch_scan(box, radius, xs, ys, pending, pending_num, is_feasible);
+        }
+
+        for (i = block; i < block_end; ++i) {
+            position.x = xs[i];
+            position.y = ys[i];
+            costs[i] = is_feasible[i] ? box_position_cost(box, position) : BOX_INFEASIBLE_COST;
+        }
+    }
+}
+
+static void
+box_batch_scan(const Box_t *box, const u32 radius, const u32 *xs, const u32 *ys, u32 *pending,
+               u32 pending_num, b32 *is_feasible)
+{
+    /* Function to check the candidates of the block by the circles of the index (pending are
+       indices of the candidates, is_feasible of them is preset to true). For the grid the
+       candidates are sorted by the cell of the pixel of the center, then every group of the same
+       cell is tested against the lanes of the 3x3 cells around it, cell by cell */
+
+    u32 i, k, begin, end, tmp, x, y;
+    u64 key;
+    u64 keys[BOX_BATCH_BLOCK]; /* Grid cells of the pending candidates (the cells of the large box
+                                  can be more than 2^32) */
+    u32 cx, cy, cx0, cy0, cx_begin, cx_end, cy_begin, cy_end, n;
+    const Box_cell_t *cell;
+
+    if ((box->index_type != BOX_INDEX_GRID) || (radius > box->max_radius)) {
+        for (k = 0; k < pending_num; ++k) {
+            i = pending[k];
+            is_feasible[i] = box_scan_is_feasible(box, xs[i], ys[i], radius);
+        }
+        return;
+    }
+
+    /* Cells of the candidates centers (clipped by the grid) */
+    for (k = 0; k < pending_num; ++k) {
+        i = pending[k];
+        x = xs[i] >> box->subpixel_bits;
+        y = ys[i] >> box->subpixel_bits;
+        cx = (x > box->BL_in.x) ? (x - box->BL_in.x) / box->cell_side : 0;
+        cy = (y > box->BL_in.y) ? (y - box->BL_in.y) / box->cell_side : 0;
+        if (cx >= box->cells_x_num) cx = box->cells_x_num - 1;
+        if (cy >= box->cells_y_num) cy = box->cells_y_num - 1;
+        keys[k] = (u64)cy * box->cells_x_num + cx;
+    }
+
+    /* Insertion sort of the candidates by the cell (the block is small) */
+    for (k = 1; k < pending_num; ++k) {
+        key = keys[k];
+        tmp = pending[k];
+        for (i = k; (i > 0) && (keys[i - 1] > key); --i) {
+            keys[i] = keys[i - 1];
+            pending[i] = pending[i - 1];
+        }
+        keys[i] = key;
+        pending[i] = tmp;
+    }
+
+    for (begin = 0; begin < pending_num; begin = end) {
+        for (end = begin + 1; (end < pending_num) && (keys[end] == keys[begin]); ++end);
+
+        /* The reach radius + max_radius is less than the cell side, so the 3x3 cells around the
+           center cell contain all the circles which can intercept the candidates of the group */
+        cx0 = (u32)(keys[begin] % box->cells_x_num);
+        cy0 = (u32)(keys[begin] / box->cells_x_num);
+        cx_begin = (cx0 > 0) ? cx0 - 1 : 0;
+        cy_begin = (cy0 > 0) ? cy0 - 1 : 0;
+        cx_end = (cx0 + 1 < box->cells_x_num) ? cx0 + 1 : cx0;
+        cy_end = (cy0 + 1 < box->cells_y_num) ? cy0 + 1 : cy0;
+
+        for (cy = cy_begin; cy <= cy_end; ++cy) {
+            for (cx = cx_begin; cx <= cx_end; ++cx) {
+                cell = box_cell_at(box, cx, cy);
+                if ((NULL == cell) || (0 == cell->records_num)) {
+                    continue;
+                }
+                n = (cell->records_num + OVERLAP_LANE_WIDTH - 1) / OVERLAP_LANE_WIDTH * OVERLAP_LANE_WIDTH;
+                for (k = begin; k < end; ++k) {
+                    i = pending[k];
+                    if (is_feasible[i] && overlap_any(cell->xs, cell->ys, cell->rs, n, (s32)xs[i], (s32)ys[i],
+                                                      (s32)(radius << box->subpixel_bits))) {
+                        is_feasible[i] = false;
+                    }
+                }
             }
         }
     }
+}
 
-    circles_list_push(box->circles_list, circle);
-    box->packed_circles_num += 1;
+u32
+box_largest_radius(const Box_t *box)
+{
+    /* Method to get the largest insertable radius (up to max_radius) of the circle in the whole box
+       (the largest maximum of the tiles taken from their counts). The search of the circle with
+       larger radius can't succeed. The maximums of the saturated tiles are not updated, so for the
+       box without the open tiles the result is only an estimate below min_radius */
+
+    u32 value;
+
+    if (NULL == box->clearance) {
+        return 0;
+    }
+    for (value = box->max_radius; value > 0; --value) {
+        if (box->clearance_counts[value] > 0) break;
+    }
+    return value;
+}
+
+b32
+box_query(const Box_t *box, const u32 x0, const u32 y0, const u32 reach, Box_visit_fn_t visit,
+          void *data)
+{
+    /* Method to visit the records of the circles which can intersect the square of half side reach
+       around (x0, y0). The grid visits all the cells with the centers closer than reach +
+       max_radius along both axes, the quadtree visits the nodes with the intersecting loose
+       squares. The callback should check the exact distance. Returns true if the query was
+       stopped by the callback */
+
+    u32 cx, cy, cx_begin, cx_end, cy_begin, cy_end, n;
+    const Box_cell_t *cell; /* Cell with the circles to visit */
+
+    u32 bits = box->subpixel_bits;
+
+    if (box->index_type == BOX_INDEX_QUADTREE) {
+        return quadtree_query(box->quadtree, x0 << bits, y0 << bits, reach << bits, visit, data);
+    }
+
+    box_cells_range(box, x0, y0, reach + box->max_radius, &cx_begin, &cx_end, &cy_begin, &cy_end);
+
+    for (cy = cy_begin; cy <= cy_end; ++cy) {
+        for (cx = cx_begin; cx <= cx_end; ++cx) {
+            cell = box_cell_at(box, cx, cy);
+            if (NULL == cell) {
+                continue;
+            }
+            for (n = 0; n < cell->records_num; ++n) {
+                if (visit(data, &cell->records[n])) {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+b32
+box_index_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius)
+{
+    /* Method to check the interceptions of the circle centered at the pixel (x0, y0) with the
+       packed circles found by the query of the spatial index (the clearance raster is not used) */
+
+    return box_scan_is_feasible(box, x0 << box->subpixel_bits, y0 << box->subpixel_bits, radius);
+}
+
+static b32
+box_scan_is_feasible(const Box_t *box, const u32 x0, const u32 y0, const u32 radius)
+{
+    /* Function to check the interceptions of the circle centered at (x0, y0) in the geometry units
+       with the packed circles found by the index. For the grid these are the cells around the
+       pixel of the center (the pixels of the intercepting centers are closer than radius +
+       max_radius), their lanes are tested by the SIMD overlap kernel */
+
+    u32 cx, cy, cx_begin, cx_end, cy_begin, cy_end, n;
+    u32 bits = box->subpixel_bits;
+    const Box_cell_t *cell; /* Cell with the circles to check */
+    Box_probe_t probe;
+
+    if (box->index_type == BOX_INDEX_QUADTREE) {
+        probe.x0 = x0;
+        probe.y0 = y0;
+        probe.radius = radius << bits;
+        return !quadtree_query(box->quadtree, x0, y0, radius << bits, box_visit_intercept, &probe);
+    }
+
+    box_cells_range(box, x0 >> bits, y0 >> bits, radius + box->max_radius, &cx_begin, &cx_end, &cy_begin,
+                    &cy_end);
+
+    for (cy = cy_begin; cy <= cy_end; ++cy) {
+        for (cx = cx_begin; cx <= cx_end; ++cx) {
+            cell = box_cell_at(box, cx, cy);
+            if ((NULL == cell) || (0 == cell->records_num)) {
+                continue;
+            }
+
+            /* Check the whole blocks of 8 circles of the cell lanes (the rest is padding) */
+            n = (cell->records_num + OVERLAP_LANE_WIDTH - 1) / OVERLAP_LANE_WIDTH * OVERLAP_LANE_WIDTH;
+            if (overlap_any(cell->xs, cell->ys, cell->rs, n, (s32)x0, (s32)y0, (s32)(radius << bits))) {
+                /* Interception is detected */
+                return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static b32
+box_visit_intercept(void *data, const Circle_record_t *record)
+{
+    /* Function to check the interception of the probe circle with the found record. Returns true
+       (stop the query) when the interception is detected */
+
+    const Box_probe_t *probe = (const Box_probe_t *)data;
+    s64 dx, dy, s; /* Distances between the circles centers and sum of the radiuses (in the units) */
+
+    dx = (s64)probe->x0 - (s64)record->x;
+    dy = (s64)probe->y0 - (s64)record->y;
+    s = (s64)probe->radius + (s64)record->radius;
+    return (dx * dx + dy * dy <= s * s);
 }
 
 void
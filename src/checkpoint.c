@@ -0,0 +1,592 @@
+/*================================================================================*/
+/* Realization of checkpoint methods                                              */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+/* Program includes: */
+#include <checkpoint.h>
+#include <utils.h>
+#include <packing.h>
+#include <packing_params.h>
+#include <box.h>
+#include <pso_algorithm.h>
+#include <contact_engine.h>
+#include <rng.h>
+#include <misc.h>
+
+/* Layout of the checkpoint file (all the numbers are little-endian):
+   - magic, version (u32);
+   - radius and color classes: number, then radius and color of every class (u32);
+   - box geometry: BL_out, outer width and height, wall width, wall and interior colors, sub-pixel
+     bits, spatial index, placement engine (u32);
+   - packing: seed (u64), rng, is_finished (u32), counters (u64);
+   - PSO: number of the PSO objects, islands and warm points capacity (u32), then for every PSO the
+     rngs of the islands and the ring of the warm start points;
+   - contact engine: number of the classes (u32), then the radius and the candidates of every class;
+   - circles: number (u32), then the x lane and the y lane of the centers (u32, in the geometry
+     units) and the lane of the classes (u8);
+   - FNV-1a hash of all the previous bytes (u64) */
+
+/* Buffer of the checkpoint file (written and read in memory) */
+struct Checkpoint_buffer {
+    u8 *data; /* Bytes of the file */
+    size_t size; /* Number of the bytes (written or available for reading) */
+    size_t capacity; /* Capacity of the data array */
+    size_t position; /* Position of the next read byte */
+    b32 is_valid; /* Flag that all the reads were inside the buffer */
+};
+typedef struct Checkpoint_buffer Checkpoint_buffer_t;
+
+/* Static functions */
+/* Function to append the bytes to the buffer (the data array grows twice when it is full) */
+static void checkpoint_put(Checkpoint_buffer_t *buffer, const u8 *bytes, const size_t size);
+/* Function to append the u32 number to the buffer */
+static void checkpoint_put_u32(Checkpoint_buffer_t *buffer, const u32 value);
+/* Function to append the u64 number to the buffer */
+static void checkpoint_put_u64(Checkpoint_buffer_t *buffer, const u64 value);
+/* Function to append the state of the random numbers generator to the buffer */
+static void checkpoint_put_rng(Checkpoint_buffer_t *buffer, const Rng_t *rng);
+/* Function to check that the buffer has the number of bytes to read */
+static b32 checkpoint_has(Checkpoint_buffer_t *buffer, const u64 size);
+/* Function to read the u8 number from the buffer (0 after the end of the buffer) */
+static u8 checkpoint_get_u8(Checkpoint_buffer_t *buffer);
+/* Function to read the u32 number from the buffer (0 after the end of the buffer) */
+static u32 checkpoint_get_u32(Checkpoint_buffer_t *buffer);
+/* Function to read the u64 number from the buffer (0 after the end of the buffer) */
+static u64 checkpoint_get_u64(Checkpoint_buffer_t *buffer);
+/* Function to read the state of the random numbers generator from the buffer */
+static void checkpoint_get_rng(Checkpoint_buffer_t *buffer, Rng_t *rng);
+/* Function to calculate the FNV-1a hash of the bytes */
+static u64 checkpoint_hash(const u8 *bytes, const size_t size);
+/* Function to find the class of the circle by its radius and color */
+static u32 checkpoint_find_class(const u32 radius, const u32 color);
+/* Function to read the state of the packing from the buffer (only checked or applied) */
+static b32 checkpoint_read_state(Checkpoint_buffer_t *buffer, Packing_t *packing, const b32 is_apply);
+
+b32
+checkpoint_save(const Packing_t *packing, const char *file_path)
+{
+    /* Method to save the state of the packing run to the file. The snapshot is collected in memory,
+       written under the temporary name, flushed to the disk and renamed to the file, so the crash
+       during the writing leaves the previous checkpoint */
+
+    const Box_t *box = packing->box;
+    const Contact_engine_t *engine = box->contact_engine;
+    const Contact_class_t *cls;
+    const PSO_t *pso;
+    Checkpoint_buffer_t buffer = {0};
+    FILE *file;
+    char *tmp_path;
+    u32 i, k, psos_num;
+    u32 cost_bits;
+    u8 class_index;
+    b32 is_written;
+
+    checkpoint_put_u32(&buffer, CHECKPOINT_MAGIC);
+    checkpoint_put_u32(&buffer, CHECKPOINT_VERSION);
+
+    /* Radius and color classes */
+    checkpoint_put_u32(&buffer, CIRCLES_TYPES);
+    for (k = 0; k < CIRCLES_TYPES; ++k) {
+        checkpoint_put_u32(&buffer, CIRCLES_RADIUSES[k]);
+        checkpoint_put_u32(&buffer, CIRCLES_COL[k]);
+    }
+
+    /* Box geometry */
+    checkpoint_put_u32(&buffer, box->BL_out.x);
+    checkpoint_put_u32(&buffer, box->BL_out.y);
+    checkpoint_put_u32(&buffer, box->width_out);
+    checkpoint_put_u32(&buffer, box->height_out);
+    checkpoint_put_u32(&buffer, box->wall_width);
+    checkpoint_put_u32(&buffer, box->wall_clr);
+    checkpoint_put_u32(&buffer, box->interior_clr);
+    checkpoint_put_u32(&buffer, box->subpixel_bits);
+    checkpoint_put_u32(&buffer, (u32)box->index_type);
+    checkpoint_put_u32(&buffer, (u32)packing->engine);
+
+    /* Random numbers generator and counters of the packing */
+    checkpoint_put_u64(&buffer, packing->seed);
+    checkpoint_put_rng(&buffer, &packing->rng);
+    checkpoint_put_u32(&buffer, (u32)packing->is_finished);
+    checkpoint_put_u64(&buffer, packing->searches_num);
+    checkpoint_put_u64(&buffer, packing->iterations_num);
+    checkpoint_put_u64(&buffer, packing->evaluations_num);
+    checkpoint_put_u64(&buffer, packing->infeasible_num);
+    checkpoint_put_u64(&buffer, packing->cache_hits);
+    checkpoint_put_u64(&buffer, packing->cache_misses);
+    checkpoint_put_u64(&buffer, packing->pruned_num);
+    checkpoint_put_u64(&buffer, packing->conflicts_num);
+
+    /* Random numbers generators of the islands and the warm start points of the PSO objects */
+    psos_num = (NULL != packing->pso) ? packing->speculation_num : 0;
+    checkpoint_put_u32(&buffer, psos_num);
+    checkpoint_put_u32(&buffer, (psos_num > 0) ? packing->pso->n_islands : 0);
+    checkpoint_put_u32(&buffer, (psos_num > 0) ? packing->pso->warm_points_capacity : 0);
+    for (k = 0; k < psos_num; ++k) {
+        pso = packing->psos[k];
+        for (i = 0; i < pso->n_islands; ++i) {
+            checkpoint_put_rng(&buffer, &pso->swarms[i].rng);
+        }
+        checkpoint_put_u32(&buffer, pso->warm_points_num);
+        checkpoint_put_u32(&buffer, pso->warm_points_next);
+        for (i = 0; i < pso->warm_points_capacity; ++i) {
+            checkpoint_put_u32(&buffer, pso->warm_points[i].x);
+            checkpoint_put_u32(&buffer, pso->warm_points[i].y);
+        }
+    }
+
+    /* Candidates of the contact engine (in their order, it resolves the ties of the costs) */
+    checkpoint_put_u32(&buffer, (NULL != engine) ? engine->classes_num : 0);
+    for (k = 0; (NULL != engine) && (k < engine->classes_num); ++k) {
+        cls = &engine->classes[k];
+        checkpoint_put_u32(&buffer, cls->radius);
+        checkpoint_put_u32(&buffer, cls->candidates_num);
+        for (i = 0; i < cls->candidates_num; ++i) {
+            memcpy(&cost_bits, &cls->candidates[i].cost, sizeof(u32));
+            checkpoint_put_u32(&buffer, cls->candidates[i].position.x);
+            checkpoint_put_u32(&buffer, cls->candidates[i].position.y);
+            checkpoint_put_u32(&buffer, cost_bits);
+        }
+    }
+
+    /* Circles in the order of the packing (lanes of the centers and the classes) */
+    checkpoint_put_u32(&buffer, box->packed_circles_num);
+    for (i = 0; i < box->packed_circles_num; ++i) {
+        checkpoint_put_u32(&buffer, box->circles[i]->position.x);
+    }
+    for (i = 0; i < box->packed_circles_num; ++i) {
+        checkpoint_put_u32(&buffer, box->circles[i]->position.y);
+    }
+    for (i = 0; i < box->packed_circles_num; ++i) {
+        class_index = (u8)checkpoint_find_class(box->circles[i]->radius, box->circles[i]->color);
+        checkpoint_put(&buffer, &class_index, 1);
+    }
+
+    checkpoint_put_u64(&buffer, checkpoint_hash(buffer.data, buffer.size));
+
+    /* Write the temporary file and replace the checkpoint by it */
+    tmp_path = (char *) calloc (strlen(file_path) + 5, sizeof(char));
+    if (NULL == tmp_path) print_error_and_exit("Error in memory allocation!\n");
+    strcpy(tmp_path, file_path);
+    strcat(tmp_path, ".tmp");
+
+    is_written = false;
+    file = fopen(tmp_path, "wb");
+    if (NULL != file) {
+        is_written = (fwrite(buffer.data, 1, buffer.size, file) == buffer.size) && (fflush(file) == 0);
+#ifndef _WIN32
+        is_written = is_written && (fsync(fileno(file)) == 0);
+#endif
+        is_written = (fclose(file) == 0) && is_written;
+    }
+    if (is_written) {
+#ifdef _WIN32
+        /* Rename does not replace the existing file on Windows */
+        remove(file_path);
+#endif
+        is_written = (rename(tmp_path, file_path) == 0);
+    }
+    if (!is_written) {
+        remove(tmp_path);
+    }
+
+    free(tmp_path);
+    free(buffer.data);
+    return is_written;
+}
+
+b32
+checkpoint_load(Packing_t *packing, const char *file_path)
+{
+    /* Method to restore the state of the packing run from the file. The whole file is read and
+       checked (hash, format and compatibility with the packing) before the packing is changed */
+
+    Checkpoint_buffer_t buffer = {0};
+    FILE *file;
+    long file_size;
+    b32 is_loaded;
+
+    file = fopen(file_path, "rb");
+    if (NULL == file) {
+        return false;
+    }
+    file_size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        file_size = ftell(file);
+    }
+    if ((file_size < (long)(2 * sizeof(u32) + sizeof(u64))) || (fseek(file, 0, SEEK_SET) != 0)) {
+        fclose(file);
+        return false;
+    }
+
+    buffer.size = (size_t)file_size;
+    buffer.data = (u8 *) calloc (buffer.size, sizeof(u8));
+    if (NULL == buffer.data) print_error_and_exit("Error in memory allocation!\n");
+    is_loaded = (fread(buffer.data, 1, buffer.size, file) == buffer.size);
+    fclose(file);
+
+    /* Hash of the file (the last 8 bytes are the hash itself, they are not read by the state) */
+    buffer.position = buffer.size - sizeof(u64);
+    buffer.is_valid = true;
+    is_loaded = is_loaded && (checkpoint_hash(buffer.data, buffer.position) == checkpoint_get_u64(&buffer));
+    buffer.size -= sizeof(u64);
+
+    /* Format of the file */
+    buffer.position = 0;
+    is_loaded = is_loaded && (checkpoint_get_u32(&buffer) == CHECKPOINT_MAGIC) &&
+        (checkpoint_get_u32(&buffer) == CHECKPOINT_VERSION);
+
+    /* The state is checked first, so the packing is changed only by the valid file */
+    is_loaded = is_loaded && checkpoint_read_state(&buffer, packing, false);
+    if (is_loaded) {
+        buffer.position = 2 * sizeof(u32);
+        checkpoint_read_state(&buffer, packing, true);
+    }
+
+    free(buffer.data);
+    return is_loaded;
+}
+
+static b32
+checkpoint_read_state(Checkpoint_buffer_t *buffer, Packing_t *packing, const b32 is_apply)
+{
+    /* Function to read the state of the packing after the file format. The first pass (is_apply
+       is false) only checks the state, the second one restores it: the box is initialized with the
+       saved geometry and the circles are restored in it with the bulk build of the spatial index
+       (malloc for the temporary arrays) */
+
+    Box_t *box = packing->box;
+    Contact_engine_t *engine = box->contact_engine;
+    Contact_candidate_t *candidates;
+    PSO_t *pso;
+    Rng_t rng;
+    V2_u32_t BL_out, point;
+    V2_u32_t *positions = NULL;
+    u32 *radiuses = NULL;
+    u32 *colors = NULL;
+    u32 width_out, height_out, wall_width, wall_clr, interior_clr, subpixel_bits;
+    u32 i, k, n, radius, psos_num, islands_num, warm_capacity, warm_num, warm_next, cost_bits;
+    u64 counters[8];
+    u64 seed;
+    b32 is_finished;
+    u8 class_index;
+
+    /* Radius and color classes should be the same as the classes of the new circles */
+    if (checkpoint_get_u32(buffer) != CIRCLES_TYPES) {
+        return false;
+    }
+    for (k = 0; k < CIRCLES_TYPES; ++k) {
+        if ((checkpoint_get_u32(buffer) != CIRCLES_RADIUSES[k]) || (checkpoint_get_u32(buffer) != CIRCLES_COL[k])) {
+            return false;
+        }
+    }
+
+    /* Box geometry (the spatial index and the engine are set by the packing creation) */
+    BL_out.x = checkpoint_get_u32(buffer);
+    BL_out.y = checkpoint_get_u32(buffer);
+    width_out = checkpoint_get_u32(buffer);
+    height_out = checkpoint_get_u32(buffer);
+    wall_width = checkpoint_get_u32(buffer);
+    wall_clr = checkpoint_get_u32(buffer);
+    interior_clr = checkpoint_get_u32(buffer);
+    subpixel_bits = checkpoint_get_u32(buffer);
+    if ((checkpoint_get_u32(buffer) != (u32)box->index_type) || (checkpoint_get_u32(buffer) != (u32)packing->engine)) {
+        return false;
+    }
+    if (((subpixel_bits != 0) && (subpixel_bits != BOX_SUBPIXEL_BITS)) ||
+        !box_size_is_valid(width_out, height_out, wall_width) ||
+        ((((u64)BL_out.x + width_out) << subpixel_bits) >= (1u << 30)) ||
+        ((((u64)BL_out.y + height_out) << subpixel_bits) >= (1u << 30))) {
+        return false;
+    }
+    if (is_apply) {
+        box_set_subpixel(box, subpixel_bits > 0);
+        packing_set_box_size(packing, width_out, height_out);
+        box_init(box, BL_out, width_out, height_out, wall_width, wall_clr, interior_clr);
+    }
+
+    /* Random numbers generator and counters of the packing */
+    seed = checkpoint_get_u64(buffer);
+    checkpoint_get_rng(buffer, &rng);
+    is_finished = (b32)checkpoint_get_u32(buffer);
+    for (k = 0; k < 8; ++k) {
+        counters[k] = checkpoint_get_u64(buffer);
+    }
+    if (is_apply) {
+        packing->seed = seed;
+        packing->rng = rng;
+        packing->is_finished = is_finished;
+        packing->searches_num = counters[0];
+        packing->iterations_num = counters[1];
+        packing->evaluations_num = counters[2];
+        packing->infeasible_num = counters[3];
+        packing->cache_hits = counters[4];
+        packing->cache_misses = counters[5];
+        packing->pruned_num = counters[6];
+        packing->conflicts_num = counters[7];
+
+        /* Committed circles of the last speculative batch are already in the box */
+        packing->slots_num = 0;
+        packing->slots_next = 0;
+    }
+
+    /* Random numbers generators of the islands and the warm start points of the PSO objects */
+    psos_num = checkpoint_get_u32(buffer);
+    islands_num = checkpoint_get_u32(buffer);
+    warm_capacity = checkpoint_get_u32(buffer);
+    if (psos_num != ((NULL != packing->pso) ? packing->speculation_num : 0)) {
+        return false;
+    }
+    for (k = 0; k < psos_num; ++k) {
+        pso = packing->psos[k];
+        if ((islands_num != pso->n_islands) || (warm_capacity != pso->warm_points_capacity)) {
+            return false;
+        }
+        for (i = 0; i < islands_num; ++i) {
+            checkpoint_get_rng(buffer, &rng);
+            if (is_apply) pso->swarms[i].rng = rng;
+        }
+        warm_num = checkpoint_get_u32(buffer);
+        warm_next = checkpoint_get_u32(buffer);
+        if ((warm_num > warm_capacity) || (warm_next >= warm_capacity)) {
+            return false;
+        }
+        for (i = 0; i < warm_capacity; ++i) {
+            point.x = checkpoint_get_u32(buffer);
+            point.y = checkpoint_get_u32(buffer);
+            if (is_apply) pso->warm_points[i] = point;
+        }
+        if (is_apply) {
+            pso->warm_points_num = warm_num;
+            pso->warm_points_next = warm_next;
+        }
+    }
+
+    /* Candidates of the contact engine (box initialization has reset them) */
+    if (checkpoint_get_u32(buffer) != ((NULL != engine) ? engine->classes_num : 0)) {
+        return false;
+    }
+    for (k = 0; (NULL != engine) && (k < engine->classes_num); ++k) {
+        radius = checkpoint_get_u32(buffer);
+        n = checkpoint_get_u32(buffer);
+        if ((radius != engine->classes[k].radius) || !checkpoint_has(buffer, (u64)n * 3 * sizeof(u32))) {
+            return false;
+        }
+        candidates = (Contact_candidate_t *) calloc ((size_t)n + 1, sizeof(Contact_candidate_t));
+        if (NULL == candidates) print_error_and_exit("Error in memory allocation!\n");
+        for (i = 0; i < n; ++i) {
+            candidates[i].position.x = checkpoint_get_u32(buffer);
+            candidates[i].position.y = checkpoint_get_u32(buffer);
+            cost_bits = checkpoint_get_u32(buffer);
+            memcpy(&candidates[i].cost, &cost_bits, sizeof(f32));
+        }
+        if (is_apply) contact_engine_set_candidates(engine, k, candidates, n);
+        free(candidates);
+    }
+
+    /* Circles (the classes are checked by the first pass, the centers are restored by the second) */
+    n = checkpoint_get_u32(buffer);
+    if (!checkpoint_has(buffer, (u64)n * (2 * sizeof(u32) + sizeof(u8)))) {
+        return false;
+    }
+    if (!is_apply) {
+        buffer->position += (size_t)n * 2 * sizeof(u32);
+        for (i = 0; i < n; ++i) {
+            if (checkpoint_get_u8(buffer) >= CIRCLES_TYPES) {
+                return false;
+            }
+        }
+        return buffer->is_valid && (buffer->position == buffer->size);
+    }
+
+    positions = (V2_u32_t *) calloc ((size_t)n + 1, sizeof(V2_u32_t));
+    if (NULL == positions) print_error_and_exit("Error in memory allocation!\n");
+    radiuses = (u32 *) calloc ((size_t)n + 1, sizeof(u32));
+    if (NULL == radiuses) print_error_and_exit("Error in memory allocation!\n");
+    colors = (u32 *) calloc ((size_t)n + 1, sizeof(u32));
+    if (NULL == colors) print_error_and_exit("Error in memory allocation!\n");
+
+    for (i = 0; i < n; ++i) {
+        positions[i].x = checkpoint_get_u32(buffer);
+    }
+    for (i = 0; i < n; ++i) {
+        positions[i].y = checkpoint_get_u32(buffer);
+    }
+    for (i = 0; i < n; ++i) {
+        class_index = checkpoint_get_u8(buffer);
+        radiuses[i] = CIRCLES_RADIUSES[class_index];
+        colors[i] = CIRCLES_COL[class_index];
+    }
+    box_restore(box, positions, radiuses, colors, n);
+
+    free(positions);
+    free(radiuses);
+    free(colors);
+    return true;
+}
+
+static void
+checkpoint_put(Checkpoint_buffer_t *buffer, const u8 *bytes, const size_t size)
+{
+    /* Function to append the bytes to the buffer (the data array grows twice when it is full) */
+    u8 *tmp_data;
+    size_t new_capacity;
+
+    if (buffer->size + size > buffer->capacity) {
+        new_capacity = (buffer->capacity > 0) ? 2 * buffer->capacity : 4096;
+        while (buffer->size + size > new_capacity) new_capacity *= 2;
+        tmp_data = (u8 *) realloc (buffer->data, new_capacity);
+        if (NULL == tmp_data) print_error_and_exit("Error in memory allocation!\n");
+        buffer->data = tmp_data;
+        buffer->capacity = new_capacity;
+    }
+    memcpy(buffer->data + buffer->size, bytes, size);
+    buffer->size += size;
+}
+
+static void
+checkpoint_put_u32(Checkpoint_buffer_t *buffer, const u32 value)
+{
+    /* Function to append the u32 number to the buffer (little-endian) */
+    u8 bytes[4];
+    u32 i;
+
+    for (i = 0; i < 4; ++i) {
+        bytes[i] = (u8)(value >> (8 * i));
+    }
+    checkpoint_put(buffer, bytes, 4);
+}
+
+static void
+checkpoint_put_u64(Checkpoint_buffer_t *buffer, const u64 value)
+{
+    /* Function to append the u64 number to the buffer (little-endian) */
+    checkpoint_put_u32(buffer, (u32)value);
+    checkpoint_put_u32(buffer, (u32)(value >> 32));
+}
+
+static void
+checkpoint_put_rng(Checkpoint_buffer_t *buffer, const Rng_t *rng)
+{
+    /* Function to append the state of the random numbers generator (with its not consumed output)
+       to the buffer */
+    u32 i, k;
+
+    for (i = 0; i < 4; ++i) {
+        for (k = 0; k < RNG_LANES; ++k) {
+            checkpoint_put_u32(buffer, rng->s[i][k]);
+        }
+    }
+    for (k = 0; k < RNG_LANES; ++k) {
+        checkpoint_put_u32(buffer, rng->out[k]);
+    }
+    checkpoint_put_u32(buffer, rng->out_index);
+}
+
+static b32
+checkpoint_has(Checkpoint_buffer_t *buffer, const u64 size)
+{
+    /* Function to check that the buffer has the number of bytes to read (the buffer becomes
+       invalid otherwise) */
+    if (!buffer->is_valid || (buffer->position > buffer->size) || (size > buffer->size - buffer->position)) {
+        buffer->is_valid = false;
+        return false;
+    }
+    return true;
+}
+
+static u8
+checkpoint_get_u8(Checkpoint_buffer_t *buffer)
+{
+    /* Function to read the u8 number from the buffer (0 after the end of the buffer) */
+    if (!checkpoint_has(buffer, 1)) {
+        return 0;
+    }
+    buffer->position += 1;
+    return buffer->data[buffer->position - 1];
+}
+
+static u32
+checkpoint_get_u32(Checkpoint_buffer_t *buffer)
+{
+    /* Function to read the u32 number from the buffer (little-endian, 0 after the end of the
+       buffer) */
+    u32 value = 0;
+    u32 i;
+
+    if (!checkpoint_has(buffer, 4)) {
+        return 0;
+    }
+    for (i = 0; i < 4; ++i) {
+        value |= (u32)buffer->data[buffer->position + i] << (8 * i);
+    }
+    buffer->position += 4;
+    return value;
+}
+
+static u64
+checkpoint_get_u64(Checkpoint_buffer_t *buffer)
+{
+    /* Function to read the u64 number from the buffer (little-endian, 0 after the end of the
+       buffer) */
+    u64 low;
+
+    low = checkpoint_get_u32(buffer);
+    return low | ((u64)checkpoint_get_u32(buffer) << 32);
+}
+
+static void
+checkpoint_get_rng(Checkpoint_buffer_t *buffer, Rng_t *rng)
+{
+    /* Function to read the state of the random numbers generator from the buffer */
+    u32 i, k;
+
+    for (i = 0; i < 4; ++i) {
+        for (k = 0; k < RNG_LANES; ++k) {
+            rng->s[i][k] = checkpoint_get_u32(buffer);
+        }
+    }
+    for (k = 0; k < RNG_LANES; ++k) {
+        rng->out[k] = checkpoint_get_u32(buffer);
+    }
+    rng->out_index = checkpoint_get_u32(buffer);
+    if (rng->out_index > RNG_LANES) {
+        buffer->is_valid = false;
+    }
+}
+
+static u64
+checkpoint_hash(const u8 *bytes, const size_t size)
+{
+    /* Function to calculate the 64-bit FNV-1a hash of the bytes */
+    u64 hash = 0xcbf29ce484222325ull;
+    size_t i;
+
+    for (i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static u32
+checkpoint_find_class(const u32 radius, const u32 color)
+{
+    /* Function to find the class of the circle by its radius and color (the first one of the
+       equal classes) */
+    u32 k;
+
+    for (k = 0; k < CIRCLES_TYPES; ++k) {
+        if ((CIRCLES_RADIUSES[k] == radius) && (CIRCLES_COL[k] == color)) {
+            return k;
+        }
+    }
+    return 0;
+}
@@ -14,6 +14,7 @@
 #include <utils.h>
 #include <misc.h>
 #include <software_rendering.h>
+#include <rng.h>
 
 Circle_t*
 circle_create(V2_u32_t center, u32 radius, u32 color)
@@ -23,6 +24,7 @@ circle_create(V2_u32_t center, u32 radius, u32 color)
     temp_circle_p = (Circle_t *) calloc (1, sizeof(Circle_t));
 
     temp_circle_p->center = center;
+    temp_circle_p->position = center;
     temp_circle_p->radius = radius;
     temp_circle_p->color = color;
 
@@ -42,7 +44,8 @@ circle_set_position(Circle_t *circle, V2_u32_t center)
     /* Method for setting the position of the circle (position of the center point) */
 
     circle->center.x = center.x;
-    circle->center.y = center.y;   
+    circle->center.y = center.y;
+    circle->position = center;
 }
 
 void
@@ -63,16 +66,17 @@ circle_render_marker(V2_u32_t marker_center, Render_Buffer_t *render_buffer)
 }
 
 void
-circle_generate_params(const u32 circles_types, const f32 *circles_prob, const u32 *circles_col,
-                       const u32 *circles_radiuses, u32 *color, u32 *radius)
+circle_generate_params(Rng_t *rng, const u32 circles_types, const f32 *circles_prob,
+                       const u32 *circles_col, const u32 *circles_radiuses, u32 *color, u32 *radius)
 {
-    /* Method for generation of the radius from the probability distribution */
+    /* Method for generation of the radius from the probability distribution (with the random
+       numbers from the rng generator) */
 
     f32 rnd_number;
     f32 left_brd, right_brd;
     u32 i;
 
-    rnd_number = rnd_f32();
+    rnd_number = rng_f32(rng);
     left_brd = 0;
     right_brd = circles_prob[1];
     
@@ -0,0 +1,384 @@
+/*================================================================================*/
+/* Realization of contact_engine methods                                          */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <math.h>
+
+/* Program includes: */
+#include <contact_engine.h>
+#include <utils.h>
+#include <circle.h>
+#include <box.h>
+#include <misc.h>
+
+/* Inflation (in the geometry units) of the circles radiuses for the tangent positions. The center
+   is rounded to the unit and touching circles are collided, so the exact tangent position is never
+   feasible */
+static const f64 contact_inflate = 0.75;
+
+/* State of the query of the neighbours of the added circle */
+struct Contact_query {
+    Contact_engine_t *engine; /* Engine collecting the neighbours */
+    const Circle_t *circle; /* Added circle */
+    u32 reach; /* Maximum distance between the circles borders to have the common candidate */
+    u32 index; /* Index of the added circle (it is the last packed circle) */
+    u32 neighbours_num; /* Number of the collected neighbours */
+    u32 bits; /* Sub-pixel bits of the box geometry units */
+};
+typedef struct Contact_query Contact_query_t;
+
+/* Static functions */
+static void contact_engine_try(Contact_class_t *cls, const Box_t *box, const f64 x, const f64 y);
+static void contact_engine_push(Contact_class_t *cls, const V2_u32_t position, const f32 cost);
+static void contact_engine_kill(Contact_class_t *cls, const Box_t *box, const Circle_t *circle);
+static u32 contact_engine_find_neighbours(Contact_engine_t *engine, const Box_t *box,
+                                          const Circle_t *circle);
+static b32 contact_engine_visit_neighbour(void *data, const Circle_record_t *other);
+
+Contact_engine_t*
+contact_engine_create(const u32 *radiuses, const u32 radiuses_num)
+{
+    /* Method for creation of the contact engine. Every different radius gets its own class of the
+       candidate positions (malloc) */
+    Contact_engine_t *tmp_engine;
+    u32 i, k;
+    b32 is_new;
+
+    tmp_engine = (Contact_engine_t *) calloc (1, sizeof(Contact_engine_t));
+    if (NULL == tmp_engine) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_engine->classes = (Contact_class_t *) calloc (radiuses_num, sizeof(Contact_class_t));
+    if (NULL == tmp_engine->classes) print_error_and_exit("Error in memory allocation!\n");
+
+    /* Classes of the different radiuses */
+    for (i = 0; i < radiuses_num; ++i) {
+        is_new = true;
+        for (k = 0; k < tmp_engine->classes_num; ++k) {
+            if (tmp_engine->classes[k].radius == radiuses[i]) is_new = false;
+        }
+        if (is_new) {
+            tmp_engine->classes[tmp_engine->classes_num].radius = radiuses[i];
+            tmp_engine->classes_num += 1;
+            if (radiuses[i] > tmp_engine->max_radius) tmp_engine->max_radius = radiuses[i];
+        }
+    }
+
+    return tmp_engine;
+}
+
+void
+contact_engine_delete(Contact_engine_t *engine)
+{
+    /* Method for deleting the contact engine */
+    u32 k;
+
+    for (k = 0; k < engine->classes_num; ++k) {
+        free(engine->classes[k].candidates);
+    }
+    free(engine->classes);
+    free(engine->neighbours);
+    free(engine);
+}
+
+void
+contact_engine_init(Contact_engine_t *engine, const Box_t *box)
+{
+    /* Initialization of the engine for the empty box: the candidates of every class are the corners
+       of the box and the middle of the floor */
+    Contact_class_t *cls;
+    u32 k;
+    f64 r, floor_y;
+
+    for (k = 0; k < engine->classes_num; ++k) {
+        cls = &engine->classes[k];
+        cls->candidates_num = 0;
+
+        r = (f64)cls->radius;
+        floor_y = (f64)box->BL_in.y + r;
+        contact_engine_try(cls, box, (f64)box->BL_in.x + r, floor_y);
+        contact_engine_try(cls, box, (f64)box->BR_in.x - r, floor_y);
+        contact_engine_try(cls, box, (f64)(box->BL_in.x + box->BR_in.x) / 2.0, floor_y);
+    }
+}
+
+void
+contact_engine_add_circle(Contact_engine_t *engine, const Box_t *box, const Circle_t *circle)
+{
+    /* Method to update the candidates after the circle has been added to the box (it should be
+       already in the box cells). The candidates covered by the circle are removed, then the new
+       candidates touching the circle and the floor, the walls or the neighbour circles are added.
+       The geometry is calculated in pix by the doubles (exact enough for the units of any box) */
+    Contact_class_t *cls;
+    const Circle_record_t *other;
+    u32 i, k, neighbours_num;
+    f64 x1, y1, r1, x2, y2, r2; /* Centers and inflated radiuses of the touched circles */
+    f64 r; /* Radius of the class */
+    f64 scale; /* Size of the geometry unit (in pix) */
+    f64 wall_x[2], floor_y, dx, dy, d, a, h;
+
+    neighbours_num = contact_engine_find_neighbours(engine, box, circle);
+    scale = 1.0 / (f64)(1u << box->subpixel_bits);
+
+    for (k = 0; k < engine->classes_num; ++k) {
+        cls = &engine->classes[k];
+        contact_engine_kill(cls, box, circle);
+
+        r = (f64)cls->radius;
+        x1 = (f64)circle->position.x * scale;
+        y1 = (f64)circle->position.y * scale;
+        r1 = (f64)circle->radius + r + contact_inflate * scale;
+
+        /* Touching the circle and the floor */
+        floor_y = (f64)box->BL_in.y + r;
+        dy = floor_y - y1;
+        if (fabs(dy) <= r1) {
+            dx = sqrt(r1 * r1 - dy * dy);
+            contact_engine_try(cls, box, x1 - dx, floor_y);
+            contact_engine_try(cls, box, x1 + dx, floor_y);
+        }
+
+        /* Touching the circle and the walls */
+        wall_x[0] = (f64)box->BL_in.x + r;
+        wall_x[1] = (f64)box->BR_in.x - r;
+        for (i = 0; i < 2; ++i) {
+            dx = wall_x[i] - x1;
+            if (fabs(dx) <= r1) {
+                dy = sqrt(r1 * r1 - dx * dx);
+                contact_engine_try(cls, box, wall_x[i], y1 - dy);
+                contact_engine_try(cls, box, wall_x[i], y1 + dy);
+            }
+        }
+
+        /* Touching the circle and the neighbour circle (intersection of the inflated circles) */
+        for (i = 0; i < neighbours_num; ++i) {
+            other = &engine->neighbours[i];
+            x2 = (f64)other->x * scale;
+            y2 = (f64)other->y * scale;
+            r2 = ((f64)other->radius + contact_inflate) * scale + r;
+
+            dx = x2 - x1;
+            dy = y2 - y1;
+            d = sqrt(dx * dx + dy * dy);
+            if ((d <= 0.0) || (d > r1 + r2)) {
+                continue;
+            }
+            a = (r1 * r1 - r2 * r2 + d * d) / (2.0 * d);
+            h = r1 * r1 - a * a;
+            if (h < 0.0) {
+                continue;
+            }
+            h = sqrt(h);
+            contact_engine_try(cls, box, x1 + (a * dx - h * dy) / d, y1 + (a * dy + h * dx) / d);
+            contact_engine_try(cls, box, x1 + (a * dx + h * dy) / d, y1 + (a * dy - h * dx) / d);
+        }
+    }
+}
+
+b32
+contact_engine_find(const Contact_engine_t *engine, const u32 radius, V2_u32_t *position)
+{
+    /* Method to find the lowest cost candidate for the circle of the radius. All the kept candidates
+       are feasible. Returns false if there are no candidates (or radius has no class) */
+    const Contact_class_t *cls = NULL;
+    u32 i, k, best_i;
+
+    for (k = 0; k < engine->classes_num; ++k) {
+        if (engine->classes[k].radius == radius) cls = &engine->classes[k];
+    }
+    if ((NULL == cls) || (cls->candidates_num == 0)) {
+        return false;
+    }
+
+    best_i = 0;
+    for (i = 1; i < cls->candidates_num; ++i) {
+        if (cls->candidates[i].cost < cls->candidates[best_i].cost) best_i = i;
+    }
+    *position = cls->candidates[best_i].position;
+    return true;
+}
+
+void
+contact_engine_set_candidates(Contact_engine_t *engine, const u32 class_index,
+                              const Contact_candidate_t *candidates, const u32 candidates_num)
+{
+    /* Method to replace the candidates of the class (restore of the saved state, the order is
+       kept, so the ties of the costs are resolved as before) */
+    Contact_class_t *cls = &engine->classes[class_index];
+    u32 i;
+
+    cls->candidates_num = 0;
+    for (i = 0; i < candidates_num; ++i) {
+        contact_engine_push(cls, candidates[i].position, candidates[i].cost);
+    }
+}
+
+static void
+contact_engine_try(Contact_class_t *cls, const Box_t *box, const f64 x, const f64 y)
+{
+    /* Function to check the tangent position (x, y) in pix and to add it as the candidate. The
+       position is rounded to the geometry unit, if it is not feasible the lowest cost feasible unit
+       around is taken (the units around are checked by one batch query of the box) */
+    s32 i, j;
+    s64 x0, y0, xi, yi;
+    s64 x_min, x_max, y_min, y_max; /* Range of the circle center coordinates (in the units) */
+    u32 k, n;
+    u32 bits = box->subpixel_bits;
+    u32 xs[8], ys[8]; /* Units around the rounded position */
+    f32 costs[8];
+    b32 feasible[8];
+    f32 best_cost;
+    V2_u32_t position, best_position = {0};
+
+    x_min = (s64)(box->BL_in.x + cls->radius) << bits;
+    x_max = (s64)(box->BR_in.x - cls->radius) << bits;
+    y_min = (s64)(box->BL_in.y + cls->radius) << bits;
+    y_max = (s64)(box->UL_in.y - cls->radius) << bits;
+
+    x0 = (s64)llround(x * (f64)(1u << bits));
+    y0 = (s64)llround(y * (f64)(1u << bits));
+    if ((x0 < x_min - 1) || (x0 > x_max + 1) || (y0 < y_min - 1) || (y0 > y_max + 1)) {
+        return;
+    }
+
+    /* The rounded position itself is taken if it is feasible */
+    if ((x0 >= x_min) && (x0 <= x_max) && (y0 >= y_min) && (y0 <= y_max)) {
+        position.x = (u32)x0;
+        position.y = (u32)y0;
+        if (box_is_feasible_at(box, position, cls->radius)) {
+            contact_engine_push(cls, position, box_position_cost(box, position));
+            return;
+        }
+    }
+
+    n = 0;
+    for (j = -1; j <= 1; ++j) {
+        for (i = -1; i <= 1; ++i) {
+            xi = x0 + i;
+            yi = y0 + j;
+            if (((i == 0) && (j == 0)) || (xi < x_min) || (xi > x_max) || (yi < y_min) || (yi > y_max)) {
+                continue;
+            }
+            xs[n] = (u32)xi;
+            ys[n] = (u32)yi;
+            n += 1;
+        }
+    }
+    box_query_batch(box, cls->radius, n, xs, ys, costs, feasible);
+
+    best_cost = -1.0f;
+    for (k = 0; k < n; ++k) {
+        if (feasible[k] && ((best_cost < 0.0f) || (costs[k] < best_cost))) {
+            best_cost = costs[k];
+            best_position.x = xs[k];
+            best_position.y = ys[k];
+        }
+    }
+
+    if (best_cost >= 0.0f) {
+        contact_engine_push(cls, best_position, best_cost);
+    }
+}
+
+static void
+contact_engine_push(Contact_class_t *cls, const V2_u32_t position, const f32 cost)
+{
+    /* Function to add the candidate into the class (the array grows twice when it is full) */
+    Contact_candidate_t *tmp_candidates;
+    u32 new_capacity;
+
+    if (cls->candidates_num == cls->candidates_capacity) {
+        new_capacity = (cls->candidates_capacity > 0) ? 2 * cls->candidates_capacity : 64;
+        tmp_candidates = (Contact_candidate_t *) realloc (cls->candidates,
+                                                          new_capacity * sizeof(Contact_candidate_t));
+        if (NULL == tmp_candidates) print_error_and_exit("Error in memory allocation!\n");
+        cls->candidates = tmp_candidates;
+        cls->candidates_capacity = new_capacity;
+    }
+    cls->candidates[cls->candidates_num].position = position;
+    cls->candidates[cls->candidates_num].cost = cost;
+    cls->candidates_num += 1;
+}
+
+static void
+contact_engine_kill(Contact_class_t *cls, const Box_t *box, const Circle_t *circle)
+{
+    /* Function to remove the candidates intercepting the circle (the same check as in the cost
+       function: touching circles are intercepting). Squared distances (in the units) are compared */
+    u32 i;
+    s64 dx, dy, s;
+
+    s = ((s64)cls->radius + (s64)circle->radius) << box->subpixel_bits;
+    i = 0;
+    while (i < cls->candidates_num) {
+        dx = (s64)cls->candidates[i].position.x - (s64)circle->position.x;
+        dy = (s64)cls->candidates[i].position.y - (s64)circle->position.y;
+        if (dx * dx + dy * dy <= s * s) {
+            cls->candidates_num -= 1;
+            cls->candidates[i] = cls->candidates[cls->candidates_num];
+        }
+        else {
+            i += 1;
+        }
+    }
+}
+
+static u32
+contact_engine_find_neighbours(Contact_engine_t *engine, const Box_t *box, const Circle_t *circle)
+{
+    /* Function to collect the packed circles close enough to the circle to touch the circle of
+       any class together with it. Returns the number of neighbours */
+    Contact_query_t query;
+
+    u32 reach;
+
+    /* Every circle is stored only once by the box index, so there are no duplicates */
+    query.engine = engine;
+    query.circle = circle;
+    query.reach = 2 * engine->max_radius + 2;
+    query.index = box->packed_circles_num - 1;
+    query.neighbours_num = 0;
+    query.bits = box->subpixel_bits;
+
+    /* Query takes the rounded center, it is less than 1 pix from the position */
+    reach = circle->radius + query.reach + ((query.bits > 0) ? 1 : 0);
+    box_query(box, circle->center.x, circle->center.y, reach, contact_engine_visit_neighbour, &query);
+
+    return query.neighbours_num;
+}
+
+static b32
+contact_engine_visit_neighbour(void *data, const Circle_record_t *other)
+{
+    /* Function to add the found record to the neighbours if its gap to the added circle is less
+       than the reach. Never stops the query */
+    Contact_query_t *query = (Contact_query_t *)data;
+    Contact_engine_t *engine = query->engine;
+    Circle_record_t *tmp_neighbours;
+    s64 dx, dy, s;
+
+    if (other->index == query->index) {
+        return false;
+    }
+
+    /* Only the circles with the gap less than the reach (records are in the units) */
+    dx = (s64)other->x - (s64)query->circle->position.x;
+    dy = (s64)other->y - (s64)query->circle->position.y;
+    s = (((s64)query->circle->radius + (s64)query->reach) << query->bits) + (s64)other->radius;
+    if (dx * dx + dy * dy > s * s) {
+        return false;
+    }
+
+    if (query->neighbours_num == engine->neighbours_capacity) {
+        engine->neighbours_capacity = (engine->neighbours_capacity > 0) ? 2 * engine->neighbours_capacity : 32;
+        tmp_neighbours = (Circle_record_t *) realloc (engine->neighbours,
+                                                      engine->neighbours_capacity * sizeof(Circle_record_t));
+        if (NULL == tmp_neighbours) print_error_and_exit("Error in memory allocation!\n");
+        engine->neighbours = tmp_neighbours;
+    }
+    engine->neighbours[query->neighbours_num] = *other;
+    query->neighbours_num += 1;
+
+    return false;
+}
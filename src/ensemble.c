@@ -0,0 +1,202 @@
+/*================================================================================*/
+/* Realization of ensemble methods                                                */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+/* Program includes: */
+#include <ensemble.h>
+#include <utils.h>
+#include <packing.h>
+#include <box.h>
+#include <thread_pool.h>
+#include <misc.h>
+
+/* Static functions */
+/* Task of the thread pool: one packing run of the ensemble */
+static void ensemble_run_task(void *task_ctx, u32 task_index);
+/* Function to get the value of the run for the statistics */
+static f64 ensemble_run_value(const Ensemble_run_t *run, const Ensemble_value_t value);
+/* Function to compare two values for the sorting (qsort) */
+static int ensemble_compare_f64(const void *a, const void *b);
+/* Function to get the percentile of the sorted values (linear interpolation between the ranks) */
+static f64 ensemble_percentile(const f64 *sorted, const u32 n, const f64 percent);
+/* Function to get the monotonic time in seconds */
+static f64 ensemble_time_sec(void);
+
+Ensemble_t*
+ensemble_create(const u32 runs_num, const u32 threads_num)
+{
+    /* Method for creation of the ensemble of runs_num runs. The runs are the tasks of the thread
+       pool with threads_num additional worker threads (malloc) */
+    Ensemble_t *tmp_ensemble;
+
+    tmp_ensemble = (Ensemble_t *) calloc (1, sizeof(Ensemble_t));
+    if (NULL == tmp_ensemble) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_ensemble->runs = (Ensemble_run_t *) calloc (runs_num, sizeof(Ensemble_run_t));
+    if (NULL == tmp_ensemble->runs) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_ensemble->runs_num = runs_num;
+    tmp_ensemble->thread_pool = thread_pool_create(threads_num);
+    pthread_mutex_init(&tmp_ensemble->mutex, NULL);
+
+    return tmp_ensemble;
+}
+
+void
+ensemble_delete(Ensemble_t *ensemble)
+{
+    /* Method for deleting the ensemble object */
+    thread_pool_delete(ensemble->thread_pool);
+    pthread_mutex_destroy(&ensemble->mutex);
+    free(ensemble->runs);
+    free(ensemble);
+}
+
+void
+ensemble_run(Ensemble_t *ensemble, const u64 seed, const u32 max_circles, Ensemble_create_fn_t create_fn,
+             Ensemble_report_fn_t report_fn, void *ctx)
+{
+    /* Method to run all the packings of the ensemble. Every run creates its own packing (box, PSO,
+       arena), so the runs share nothing but the report. Run k uses seed + k, so it is reproduced
+       by the single run with this seed */
+    ensemble->seed = seed;
+    ensemble->max_circles = max_circles;
+    ensemble->create_fn = create_fn;
+    ensemble->report_fn = report_fn;
+    ensemble->ctx = ctx;
+    ensemble->runs_done = 0;
+
+    thread_pool_run(ensemble->thread_pool, ensemble_run_task, ensemble, ensemble->runs_num);
+}
+
+static void
+ensemble_run_task(void *task_ctx, u32 task_index)
+{
+    /* Task of the thread pool: the packing run until the box is full (or the circles limit is
+       reached). The result is written to the own element of the runs array */
+    Ensemble_t *ensemble = (Ensemble_t *)task_ctx;
+    Ensemble_run_t *run = &ensemble->runs[task_index];
+    Packing_t *packing;
+    f64 begin_time;
+
+    run->index = task_index;
+    run->seed = ensemble->seed + task_index;
+
+    begin_time = ensemble_time_sec();
+    packing = ensemble->create_fn(ensemble->ctx, run->seed);
+    while (NULL != packing_step(packing)) {
+        if ((ensemble->max_circles > 0) && (packing->box->packed_circles_num >= ensemble->max_circles)) {
+            break;
+        }
+    }
+    run->time = ensemble_time_sec() - begin_time;
+
+    run->packed_circles_num = packing->box->packed_circles_num;
+    run->occupied_fraction = packing->box->occupied_fraction;
+    run->searches_num = packing->searches_num;
+    packing_delete(packing);
+
+    pthread_mutex_lock(&ensemble->mutex);
+    ensemble->runs_done += 1;
+    if (NULL != ensemble->report_fn) {
+        ensemble->report_fn(ensemble->ctx, run);
+    }
+    pthread_mutex_unlock(&ensemble->mutex);
+}
+
+void
+ensemble_calc_stats(const Ensemble_t *ensemble, const Ensemble_value_t value, Ensemble_stats_t *stats)
+{
+    /* Method to calculate the mean, the sample variance and the percentiles of the value over all
+       the runs (malloc for the sorted values) */
+    f64 *sorted;
+    f64 sum, delta;
+    u32 i, n = ensemble->runs_num;
+
+    *stats = (Ensemble_stats_t){0};
+    if (0 == n) {
+        return;
+    }
+
+    sorted = (f64 *) calloc (n, sizeof(f64));
+    if (NULL == sorted) print_error_and_exit("Error in memory allocation!\n");
+
+    sum = 0.0;
+    for (i = 0; i < n; ++i) {
+        sorted[i] = ensemble_run_value(&ensemble->runs[i], value);
+        sum += sorted[i];
+    }
+    stats->mean = sum / (f64)n;
+
+    sum = 0.0;
+    for (i = 0; i < n; ++i) {
+        delta = sorted[i] - stats->mean;
+        sum += delta * delta;
+    }
+    stats->variance = (n > 1) ? sum / (f64)(n - 1) : 0.0;
+
+    qsort(sorted, n, sizeof(f64), ensemble_compare_f64);
+    stats->min = sorted[0];
+    stats->p5 = ensemble_percentile(sorted, n, 5.0);
+    stats->p25 = ensemble_percentile(sorted, n, 25.0);
+    stats->median = ensemble_percentile(sorted, n, 50.0);
+    stats->p75 = ensemble_percentile(sorted, n, 75.0);
+    stats->p95 = ensemble_percentile(sorted, n, 95.0);
+    stats->max = sorted[n - 1];
+
+    free(sorted);
+}
+
+static f64
+ensemble_run_value(const Ensemble_run_t *run, const Ensemble_value_t value)
+{
+    /* Function to get the value of the run for the statistics */
+    switch (value) {
+    case ENSEMBLE_VALUE_CIRCLES:
+        return (f64)run->packed_circles_num;
+    case ENSEMBLE_VALUE_FRACTION:
+        return (f64)run->occupied_fraction;
+    default:
+        return run->time;
+    }
+}
+
+static int
+ensemble_compare_f64(const void *a, const void *b)
+{
+    /* Function to compare two values for the sorting (qsort) */
+    f64 x = *(const f64 *)a;
+    f64 y = *(const f64 *)b;
+    return (x > y) - (x < y);
+}
+
+static f64
+ensemble_percentile(const f64 *sorted, const u32 n, const f64 percent)
+{
+    /* Function to get the percentile of the sorted values. The rank (n - 1) * percent / 100 is
+       interpolated linearly between the neighbour values */
+    f64 rank, weight;
+    u32 i;
+
+    rank = (f64)(n - 1) * percent / 100.0;
+    i = (u32)rank;
+    if (i + 1 >= n) {
+        return sorted[n - 1];
+    }
+    weight = rank - (f64)i;
+    return sorted[i] + (sorted[i + 1] - sorted[i]) * weight;
+}
+
+static f64
+ensemble_time_sec(void)
+{
+    /* Function to get the monotonic time in seconds */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1.0e-9;
+}
@@ -0,0 +1,551 @@
+/*=============================================================================
+  Headless platform: batch packing runner without window and timer
+  =============================================================================*/
+
+/* Standard incudes: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* Program includes: */
+#include <utils.h>
+#include <packing.h>
+#include <packing_params.h>
+#include <pso_algorithm.h>
+#include <ensemble.h>
+#include <checkpoint.h>
+#include <placement_log.h>
+
+/* Largest outer size of the box (the coordinates of the overlap kernels are below 2^30) */
+#define HEADLESS_MAX_BOX_SIZE (1u << 29)
+
+/* Default interval (in seconds) between the checkpoints of the run */
+#define HEADLESS_CHECKPOINT_INTERVAL 60
+
+/* Options of the headless run (from the command line) */
+struct Headless_options {
+    Packing_engine_t engine; /* Engine of the circle placement */
+    Box_index_t index_type; /* Spatial index of the packed circles */
+    u32 n_pop; /* Number of particles in the PSO swarm */
+    u32 n_islands; /* Number of independent PSO swarms (islands) */
+    u32 threads_num; /* Number of additional worker threads for the PSO */
+    u32 max_circles; /* Stop after packing this number of circles (0 - until the box is full) */
+    u32 box_width; /* Outer width of the box (in pix) */
+    u32 box_height; /* Outer height of the box (in pix) */
+    u64 seed; /* Seed of the random numbers */
+    u32 stall_limit; /* Iterations without improvement of the PSO global best to stop the search */
+    f32 spread_tol; /* Spread of the PSO swarm (in pix) to stop the search */
+    f32 warm_fraction; /* Fraction of the PSO particles seeded around the warm start points */
+    u32 warm_spread; /* Seeding distance (in pix) around the warm start points */
+    b32 use_cache; /* Flag to use the cache of the PSO costs evaluations */
+    f32 surface_fraction; /* Fraction of the PSO particles seeded above the skyline */
+    u32 surface_spread; /* Height of the seeding band (in pix) above the skyline */
+    b32 use_pruning; /* Flag to resolve the PSO candidates not improving the bests by the skyline */
+    b32 use_open_sampling; /* Flag to randomize the PSO particles only in the open tiles of the box */
+    b32 use_subpixel; /* Flag to place the circles centers with the sub-pixel precision */
+    u32 speculation_num; /* Number of the circles searched concurrently by the PSO */
+    u32 runs_num; /* Number of the independent runs of the ensemble (1 - single run) */
+    char *checkpoint_path; /* File of the checkpoints of the run (NULL - no checkpoints) */
+    u32 checkpoint_interval; /* Interval (in seconds) between the checkpoints */
+    char *restore_path; /* Checkpoint file to continue the run from (NULL - new run) */
+    char *log_path; /* File of the placement log (NULL - no log) */
+    Placement_log_format_t log_format; /* Encoding of the placement log */
+    b32 is_verified; /* Flag to check the packed circles for the interceptions after the run */
+};
+typedef struct Headless_options Headless_options_t;
+
+/* State of the check of one packed circle against its neighbours */
+struct Headless_verify {
+    const Box_t *box; /* Box of the packed circles */
+    const Circle_t *circle; /* Checked circle */
+    u32 index; /* Index of the checked circle */
+    u64 overlaps_num; /* Number of the found intercepting pairs */
+};
+typedef struct Headless_verify Headless_verify_t;
+
+static void
+print_usage_and_exit(char *program_name)
+{
+    /* Function to print the command line usage and exit the program */
+    printf("Usage: %s [options]\n", program_name);
+    printf("  --engine NAME  placement engine: pso or contact (default pso)\n");
+    printf("  --index NAME   spatial index of the box: grid or quadtree (default grid)\n");
+    printf("  --pop N        number of particles in the PSO swarm (default %u)\n", PSO_N_POP);
+    printf("  --islands N    number of independent PSO swarms (default 1)\n");
+    printf("  --threads N    number of additional worker threads for the PSO (default 0)\n");
+    printf("  --speculate N  number of circles searched concurrently against the same box (default %u)\n",
+           PSO_SPECULATION_NUM);
+    printf("  --max-circles N  stop after N packed circles (default 0 - until the box is full)\n");
+    printf("  --seed N       seed of the random numbers (default - current time)\n");
+    printf("  --runs N       number of independent runs with the seeds N, N+1, ... (default 1)\n");
+    printf("  --checkpoint PATH  save the state of the run to the file periodically and at the end\n");
+    printf("  --checkpoint-interval N  seconds between the checkpoints (default %u)\n",
+           HEADLESS_CHECKPOINT_INTERVAL);
+    printf("  --restore PATH continue the run saved to the checkpoint file (with the same options)\n");
+    printf("  --log PATH     write the event of every placed circle to the file\n");
+    printf("  --log-format NAME  encoding of the placement log: csv, ndjson or binary (default csv)\n");
+    printf("  --verify       check the packed circles for the interceptions (exit code 2 if found)\n");
+    printf("  --box-width N  outer width of the box in pixels (default %u)\n", BOX_WIDTH_OUT);
+    printf("  --box-height N outer height of the box in pixels (default %u)\n", BOX_HEIGHT_OUT);
+    printf("  --stall N      stop the search after N iterations without improvement (default %u, 0 - off)\n",
+           PSO_STALL_LIMIT);
+    printf("  --spread X     stop the search when the swarm spread is below X pixels (default %.2f, 0 - off)\n",
+           (f64)PSO_SPREAD_TOL);
+    printf("  --warm X       fraction of particles seeded near the previous placements (default %.2f, 0 - off)\n",
+           (f64)PSO_WARM_FRACTION);
+    printf("  --warm-spread N  seeding distance in pixels around the previous placements (default %u)\n",
+           PSO_WARM_SPREAD);
+    printf("  --no-cache     do not use the cache of the PSO costs evaluations\n");
+    printf("  --surface X    fraction of particles seeded above the fill surface (default %.2f, 0 - off)\n",
+           (f64)PSO_SURFACE_FRACTION);
+    printf("  --surface-spread N  height in pixels of the seeding band above the fill surface (default %u)\n",
+           PSO_SURFACE_SPREAD);
+    printf("  --prune        resolve the PSO candidates which can't improve the bests by the fill surface\n");
+    printf("  --sample-all   randomize the PSO particles over the whole box, also in the saturated tiles\n");
+    printf("  --subpixel     place the circles centers with the sub-pixel precision (1/%u pixel)\n",
+           1u << BOX_SUBPIXEL_BITS);
+    exit(1);
+}
+
+static u32
+parse_u32_option(int argc, char **argv, int *i)
+{
+    /* Function to parse the unsigned value following the option argv[*i] */
+    char *end;
+    unsigned long value;
+
+    if (*i + 1 >= argc) print_usage_and_exit(argv[0]);
+    *i += 1;
+    value = strtoul(argv[*i], &end, 10);
+    if ((*end != '\0') || (end == argv[*i])) print_usage_and_exit(argv[0]);
+    return (u32)value;
+}
+
+static void
+parse_options(int argc, char **argv, Headless_options_t *options)
+{
+    /* Function to parse the command line options */
+    int i;
+    char *end;
+
+    options->engine = PACKING_ENGINE_PSO;
+    options->index_type = BOX_INDEX_GRID;
+    options->n_pop = PSO_N_POP;
+    options->n_islands = 1;
+    options->threads_num = 0;
+    options->max_circles = 0;
+    options->box_width = BOX_WIDTH_OUT;
+    options->box_height = BOX_HEIGHT_OUT;
+    options->seed = (u64)time(NULL);
+    options->stall_limit = PSO_STALL_LIMIT;
+    options->spread_tol = PSO_SPREAD_TOL;
+    options->warm_fraction = PSO_WARM_FRACTION;
+    options->warm_spread = PSO_WARM_SPREAD;
+    options->use_cache = true;
+    options->surface_fraction = PSO_SURFACE_FRACTION;
+    options->surface_spread = PSO_SURFACE_SPREAD;
+    options->use_pruning = PSO_USE_PRUNING;
+    options->use_open_sampling = PSO_USE_OPEN_SAMPLING;
+    options->use_subpixel = BOX_USE_SUBPIXEL;
+    options->speculation_num = PSO_SPECULATION_NUM;
+    options->runs_num = 1;
+    options->checkpoint_path = NULL;
+    options->checkpoint_interval = HEADLESS_CHECKPOINT_INTERVAL;
+    options->restore_path = NULL;
+    options->log_path = NULL;
+    options->log_format = PLACEMENT_LOG_CSV;
+    options->is_verified = false;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--engine") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            if (strcmp(argv[i], "pso") == 0) options->engine = PACKING_ENGINE_PSO;
+            else if (strcmp(argv[i], "contact") == 0) options->engine = PACKING_ENGINE_CONTACT;
+            else print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--index") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            if (strcmp(argv[i], "grid") == 0) options->index_type = BOX_INDEX_GRID;
+            else if (strcmp(argv[i], "quadtree") == 0) options->index_type = BOX_INDEX_QUADTREE;
+            else print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--pop") == 0) {
+            options->n_pop = parse_u32_option(argc, argv, &i);
+            if (options->n_pop == 0) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--islands") == 0) {
+            options->n_islands = parse_u32_option(argc, argv, &i);
+            if (options->n_islands == 0) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0) {
+            options->threads_num = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--speculate") == 0) {
+            options->speculation_num = parse_u32_option(argc, argv, &i);
+            if (options->speculation_num == 0) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->seed = strtoull(argv[i], &end, 10);
+            if ((*end != '\0') || (end == argv[i])) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--runs") == 0) {
+            options->runs_num = parse_u32_option(argc, argv, &i);
+            if (options->runs_num == 0) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--checkpoint") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->checkpoint_path = argv[i];
+        }
+        else if (strcmp(argv[i], "--checkpoint-interval") == 0) {
+            options->checkpoint_interval = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--restore") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->restore_path = argv[i];
+        }
+        else if (strcmp(argv[i], "--log") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->log_path = argv[i];
+        }
+        else if (strcmp(argv[i], "--log-format") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            if (strcmp(argv[i], "csv") == 0) options->log_format = PLACEMENT_LOG_CSV;
+            else if (strcmp(argv[i], "ndjson") == 0) options->log_format = PLACEMENT_LOG_NDJSON;
+            else if (strcmp(argv[i], "binary") == 0) options->log_format = PLACEMENT_LOG_BINARY;
+            else print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--verify") == 0) {
+            options->is_verified = true;
+        }
+        else if (strcmp(argv[i], "--max-circles") == 0) {
+            options->max_circles = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--box-width") == 0) {
+            options->box_width = parse_u32_option(argc, argv, &i);
+            if ((options->box_width <= 2 * BOX_WALL_WIDTH) || (options->box_width > HEADLESS_MAX_BOX_SIZE)) {
+                print_usage_and_exit(argv[0]);
+            }
+        }
+        else if (strcmp(argv[i], "--box-height") == 0) {
+            options->box_height = parse_u32_option(argc, argv, &i);
+            if ((options->box_height <= BOX_WALL_WIDTH) || (options->box_height > HEADLESS_MAX_BOX_SIZE)) {
+                print_usage_and_exit(argv[0]);
+            }
+        }
+        else if (strcmp(argv[i], "--stall") == 0) {
+            options->stall_limit = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--spread") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->spread_tol = strtof(argv[i], &end);
+            if ((*end != '\0') || (end == argv[i]) || (options->spread_tol < 0.0f)) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--warm") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->warm_fraction = strtof(argv[i], &end);
+            if ((*end != '\0') || (end == argv[i]) || (options->warm_fraction < 0.0f) ||
+                (options->warm_fraction > 1.0f)) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--warm-spread") == 0) {
+            options->warm_spread = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--no-cache") == 0) {
+            options->use_cache = false;
+        }
+        else if (strcmp(argv[i], "--surface") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->surface_fraction = strtof(argv[i], &end);
+            if ((*end != '\0') || (end == argv[i]) || (options->surface_fraction < 0.0f) ||
+                (options->surface_fraction > 1.0f)) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--surface-spread") == 0) {
+            options->surface_spread = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--prune") == 0) {
+            options->use_pruning = true;
+        }
+        else if (strcmp(argv[i], "--sample-all") == 0) {
+            options->use_open_sampling = false;
+        }
+        else if (strcmp(argv[i], "--subpixel") == 0) {
+            options->use_subpixel = true;
+        }
+        else {
+            print_usage_and_exit(argv[0]);
+        }
+    }
+
+    /* Coordinates of the geometry units are also below 2^30 */
+    if (options->use_subpixel && ((options->box_width > HEADLESS_MAX_BOX_SIZE >> BOX_SUBPIXEL_BITS) ||
+                                  (options->box_height > HEADLESS_MAX_BOX_SIZE >> BOX_SUBPIXEL_BITS))) {
+        print_usage_and_exit(argv[0]);
+    }
+
+    /* Number of the clearance tiles of the box is limited as well (wide and tall box together) */
+    if (!box_size_is_valid(options->box_width, options->box_height, BOX_WALL_WIDTH)) {
+        print_usage_and_exit(argv[0]);
+    }
+
+    /* Checkpoints and the placement log are made only for the single run */
+    if ((options->runs_num > 1) && ((NULL != options->checkpoint_path) || (NULL != options->restore_path) ||
+                                    (NULL != options->log_path))) {
+        print_usage_and_exit(argv[0]);
+    }
+}
+
+static f64
+get_time_sec(void)
+{
+    /* Function to get the monotonic time in seconds */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1.0e-9;
+}
+
+static b32
+verify_visit(void *data, const Circle_record_t *other)
+{
+    /* Function to count the interception of the checked circle with the later packed circle (every
+       pair is counted once). Touching circles are intercepting as in the placement */
+    Headless_verify_t *verify = (Headless_verify_t *)data;
+    s64 dx, dy, s;
+
+    if (other->index > verify->index) {
+        dx = (s64)other->x - (s64)verify->circle->position.x;
+        dy = (s64)other->y - (s64)verify->circle->position.y;
+        s = (s64)other->radius + ((s64)verify->circle->radius << verify->box->subpixel_bits);
+        if (dx * dx + dy * dy <= s * s) {
+            verify->overlaps_num += 1;
+        }
+    }
+    return false;
+}
+
+static b32
+verify_packing(const Packing_t *packing)
+{
+    /* Function to check all the packed circles: no interceptions with the neighbours found by the
+       spatial index and the circles inside the interior of the box (in the geometry units) */
+    const Box_t *box = packing->box;
+    const Circle_t *circle;
+    Headless_verify_t verify;
+    u64 r, outside_num;
+    u32 i, bits = box->subpixel_bits;
+
+    verify.box = box;
+    verify.overlaps_num = 0;
+    outside_num = 0;
+    for (i = 0; i < box->packed_circles_num; ++i) {
+        circle = box->circles[i];
+        verify.circle = circle;
+        verify.index = i;
+        box_query(box, circle->center.x, circle->center.y, circle->radius + box->max_radius + 1, verify_visit,
+                  &verify);
+
+        r = (u64)circle->radius << bits;
+        if (((u64)circle->position.x < ((u64)box->BL_in.x << bits) + r) ||
+            ((u64)circle->position.x + r > ((u64)box->BR_in.x << bits)) ||
+            ((u64)circle->position.y < ((u64)box->BL_in.y << bits) + r) ||
+            ((u64)circle->position.y + r > ((u64)box->UL_in.y << bits))) {
+            outside_num += 1;
+        }
+    }
+
+    printf("Intercepting pairs: %llu\n", (unsigned long long)verify.overlaps_num);
+    printf("Circles outside:  %llu\n", (unsigned long long)outside_num);
+    return (0 == verify.overlaps_num) && (0 == outside_num);
+}
+
+static Packing_t*
+create_packing(void *ctx, const u64 seed)
+{
+    /* Function to create the initialized packing with the options of the command line. In the
+       ensemble the worker threads run the whole packings, so the packing gets no threads */
+    const Headless_options_t *options = (const Headless_options_t *)ctx;
+    Packing_t *packing;
+    PSO_t *pso;
+    u32 k;
+
+    /* Box is not displayed, so it is placed at the origin without the world */
+    packing = packing_create(options->engine, options->index_type, options->n_pop, options->n_islands,
+                             (options->runs_num > 1) ? 0 : options->threads_num);
+    packing_set_box_size(packing, options->box_width, options->box_height);
+    box_set_subpixel(packing->box, options->use_subpixel);
+    packing_set_speculation(packing, options->speculation_num);
+    packing_init(packing, NULL, 0, seed);
+    for (k = 0; (NULL != packing->pso) && (k < packing->speculation_num); ++k) {
+        pso = packing->psos[k];
+        pso_set_early_termination(pso, options->stall_limit, options->spread_tol);
+        pso_set_warm_start(pso, options->warm_fraction, options->warm_spread);
+        pso_set_cost_cache(pso, options->use_cache);
+        pso_set_surface_start(pso, options->surface_fraction, options->surface_spread);
+        pso_set_pruning(pso, options->use_pruning);
+        pso_set_open_sampling(pso, options->use_open_sampling);
+    }
+
+    return packing;
+}
+
+static void
+report_run(void *ctx, const Ensemble_run_t *run)
+{
+    /* Function to print the result of the finished run of the ensemble (streamed in the order of
+       the completion) */
+    (void)ctx;
+    printf("Run %u: seed %llu, packed circles %u, occupied fraction %.4f, time %.3f s\n", run->index,
+           (unsigned long long)run->seed, run->packed_circles_num, (f64)run->occupied_fraction, run->time);
+    fflush(stdout);
+}
+
+static void
+print_stats(const char *name, const Ensemble_stats_t *stats)
+{
+    /* Function to print the row of the ensemble statistics table */
+    printf("%-18s %11.6g %11.6g %11.6g %11.6g %11.6g %11.6g %11.6g %11.6g %11.6g\n", name, stats->mean,
+           stats->variance, stats->min, stats->p5, stats->p25, stats->median, stats->p75, stats->p95, stats->max);
+}
+
+static void
+run_ensemble(Headless_options_t *options)
+{
+    /* Function to run the ensemble of the independent packings (threads_num additional worker
+       threads run the whole packings) and to print the statistics of the runs */
+    Ensemble_t *ensemble;
+    Ensemble_stats_t stats;
+    f64 begin_time, total_time;
+    u64 circles_sum;
+    u32 i;
+
+    ensemble = ensemble_create(options->runs_num, options->threads_num);
+
+    begin_time = get_time_sec();
+    ensemble_run(ensemble, options->seed, options->max_circles, create_packing, report_run, options);
+    total_time = get_time_sec() - begin_time;
+
+    circles_sum = 0;
+    for (i = 0; i < ensemble->runs_num; ++i) {
+        circles_sum += ensemble->runs[i].packed_circles_num;
+    }
+
+    printf("Runs:             %u (seeds %llu...%llu)\n", ensemble->runs_num, (unsigned long long)options->seed,
+           (unsigned long long)(options->seed + ensemble->runs_num - 1));
+    printf("Box size:         %u x %u\n", options->box_width, options->box_height);
+    printf("%-18s %11s %11s %11s %11s %11s %11s %11s %11s %11s\n", "", "mean", "variance", "min", "p5", "p25",
+           "median", "p75", "p95", "max");
+    ensemble_calc_stats(ensemble, ENSEMBLE_VALUE_CIRCLES, &stats);
+    print_stats("Packed circles", &stats);
+    ensemble_calc_stats(ensemble, ENSEMBLE_VALUE_FRACTION, &stats);
+    print_stats("Occupied fraction", &stats);
+    ensemble_calc_stats(ensemble, ENSEMBLE_VALUE_TIME, &stats);
+    print_stats("Run time, s", &stats);
+    printf("Total time:       %.3f s\n", total_time);
+    printf("Circles / second: %.1f\n", (total_time > 0.0) ? (f64)circles_sum / total_time : 0.0);
+
+    ensemble_delete(ensemble);
+}
+
+/* Entry point for the headless application */
+int
+main(int argc, char **argv)
+{
+    Headless_options_t options;
+    Packing_t *packing;
+    Placement_log_t *placement_log = NULL;
+    f64 begin_time, total_time, checkpoint_time;
+    u32 restored_num;
+
+    parse_options(argc, argv, &options);
+
+    if (options.runs_num > 1) {
+        run_ensemble(&options);
+        return 0;
+    }
+
+    packing = create_packing(&options, options.seed);
+
+    /* Continue the saved run (its seed and box replace the options) */
+    begin_time = get_time_sec();
+    if ((NULL != options.restore_path) && !checkpoint_load(packing, options.restore_path)) {
+        fprintf(stderr, "Can't restore the run from the checkpoint %s\n", options.restore_path);
+        packing_delete(packing);
+        return 1;
+    }
+    restored_num = packing->box->packed_circles_num;
+    if (NULL != options.restore_path) {
+        printf("Restored circles: %u (%.3f s)\n", restored_num, get_time_sec() - begin_time);
+    }
+
+    /* Log of the circles placed from now on (the restored ones are not repeated) */
+    if (NULL != options.log_path) {
+        placement_log = placement_log_create(options.log_path, options.log_format, packing->box->subpixel_bits);
+        if (NULL == placement_log) {
+            fprintf(stderr, "Can't open the placement log %s\n", options.log_path);
+            packing_delete(packing);
+            return 1;
+        }
+        packing_set_placement_log(packing, placement_log);
+    }
+
+    /* Run the packing until the box is full (or the circles limit is reached) */
+    begin_time = get_time_sec();
+    checkpoint_time = begin_time;
+    while (NULL != packing_step(packing)) {
+        if ((options.max_circles > 0) && (packing->box->packed_circles_num >= options.max_circles)) {
+            break;
+        }
+        if ((NULL != options.checkpoint_path) &&
+            (get_time_sec() - checkpoint_time >= (f64)options.checkpoint_interval)) {
+            if (!checkpoint_save(packing, options.checkpoint_path)) {
+                fprintf(stderr, "Can't save the checkpoint %s\n", options.checkpoint_path);
+            }
+            checkpoint_time = get_time_sec();
+        }
+    }
+    if ((NULL != placement_log) && !placement_log_delete(placement_log)) {
+        fprintf(stderr, "Can't write the placement log %s\n", options.log_path);
+    }
+    total_time = get_time_sec() - begin_time;
+
+    if ((NULL != options.checkpoint_path) && !checkpoint_save(packing, options.checkpoint_path)) {
+        fprintf(stderr, "Can't save the checkpoint %s\n", options.checkpoint_path);
+    }
+
+    /* Print the statistics of the run */
+    printf("Seed:             %llu\n", (unsigned long long)packing->seed);
+    printf("Packed circles:   %u\n", packing->box->packed_circles_num);
+    printf("Box size:         %u x %u\n", packing->box->width_out, packing->box->height_out);
+    printf("Occupied fraction: %.4f\n", (f64)packing->box->occupied_fraction);
+    printf("Searches:         %llu\n", (unsigned long long)packing->searches_num);
+    printf("PSO iterations / search: %.1f\n",
+           (packing->searches_num > 0) ? (f64)packing->iterations_num / (f64)packing->searches_num : 0.0);
+    printf("Infeasible evaluations: %.1f %%\n",
+           (packing->evaluations_num > 0) ? 100.0 * (f64)packing->infeasible_num / (f64)packing->evaluations_num : 0.0);
+    printf("Cost cache hits:  %.1f %%\n", (packing->cache_hits + packing->cache_misses > 0) ?
+           100.0 * (f64)packing->cache_hits / (f64)(packing->cache_hits + packing->cache_misses) : 0.0);
+    printf("Pruned evaluations: %.1f %%\n",
+           (packing->evaluations_num > 0) ? 100.0 * (f64)packing->pruned_num / (f64)packing->evaluations_num : 0.0);
+    printf("Speculative conflicts: %.1f %%\n",
+           (packing->searches_num > 0) ? 100.0 * (f64)packing->conflicts_num / (f64)packing->searches_num : 0.0);
+    printf("Total time:       %.3f s\n", total_time);
+    printf("Circles / second: %.1f\n", (total_time > 0.0) ? (f64)(packing->box->packed_circles_num - restored_num) / total_time : 0.0);
+
+    if (options.is_verified && !verify_packing(packing)) {
+        packing_delete(packing);
+        return 2;
+    }
+
+    packing_delete(packing);
+    return 0;
+}
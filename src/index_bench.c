@@ -0,0 +1,439 @@
+/*=============================================================================
+  Index benchmark: comparison of the box spatial index backends for the wide
+  (polydisperse) distribution of the circles radiuses
+  =============================================================================*/
+
+/* Standard incudes: */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+/* Program includes: */
+#include <utils.h>
+#include <box.h>
+#include <circle.h>
+#include <quadtree.h>
+#include <rng.h>
+#include <misc.h>
+#include <overlap.h>
+
+/* Width of the box wall of the benchmark (in pix) */
+#define BENCH_WALL_WIDTH 10
+
+/* Number of the random lanes of the overlap kernels check */
+#define BENCH_CHECK_LANES 200000
+
+/* Largest number of the circles in the lane of the overlap kernels check and the capacity of the
+   lanes (rounded up to OVERLAP_LANE_WIDTH) */
+#define BENCH_CHECK_MAX_CIRCLES 45
+#define BENCH_CHECK_LANE_SIZE 48
+
+/* Alignment of the lanes of the overlap kernels check (see overlap.h) */
+#define BENCH_LANE_ALIGNMENT 32
+
+/* Names of the overlap kernels (in the order of Overlap_kernel_t) */
+static const char *BENCH_KERNEL_NAMES[OVERLAP_KERNELS_NUM] = {"scalar", "sse2", "avx2"};
+
+/* Boundary case of the overlap kernels check: the circle of the lane against the tested circle */
+struct Bench_overlap_case {
+    s32 x, y, r; /* Circle of the lane */
+    s32 x0, y0, r0; /* Tested circle */
+    b32 is_intercepting; /* Expected result (touching circles are intercepting) */
+};
+typedef struct Bench_overlap_case Bench_overlap_case_t;
+
+/* Boundary cases of the exact test: the distances of the 3-4-5 triangles equal to the sum of the
+   radiuses and differing from it by one unit, also with the coordinates near the limit 2^30. The
+   squares of such distances differ by less than the precision of f32 or f64 */
+static const Bench_overlap_case_t BENCH_OVERLAP_CASES[] = {
+    {16, 18, 4, 10, 10, 6, true}, /* Tangent, distance 10 */
+    {16, 18, 5, 10, 10, 6, true}, /* Overlap by one unit */
+    {16, 18, 3, 10, 10, 6, false}, /* Gap of one unit */
+    {671088639, 536870911, 402653184, 1073741823, 1073741823, 268435456, true}, /* Tangent, distance 5 * 2^27 */
+    {671088639, 536870911, 402653185, 1073741823, 1073741823, 268435456, true}, /* Overlap by one unit */
+    {671088639, 536870911, 402653183, 1073741823, 1073741823, 268435456, false}, /* Gap of one unit */
+    {0, 0, 536870911, 1073741823, 0, 536870912, true}, /* Tangent, distance 2^30 - 1 */
+    {0, 1, 536870911, 1073741823, 0, 536870912, false}, /* Squared distance above by one */
+    {0, 1, 536870912, 1073741823, 0, 536870912, true} /* Sum of the radiuses 2^30 */
+};
+
+/* Options of the benchmark (from the command line) */
+struct Bench_options {
+    u32 attempts; /* Number of the random placement attempts */
+    u32 queries; /* Number of the random feasibility queries in the filled box */
+    u32 r_min; /* Smallest radius of the circles */
+    u32 r_max; /* Largest radius of the circles */
+    u32 size; /* Outer width and height of the box */
+    u64 seed; /* Seed of the random numbers */
+    b32 is_kernels_check; /* Flag to compare the overlap kernels with the scalar one (no benchmark) */
+};
+typedef struct Bench_options Bench_options_t;
+
+/* Results of the benchmark of one backend */
+struct Bench_result {
+    u32 placed_num; /* Number of the placed circles */
+    u64 checksum; /* Checksum of the placed circles (the same for the correct backends) */
+    u32 feasible_num; /* Number of the feasible queries in the filled box */
+    f64 place_time; /* Total time of the placement attempts (in sec) */
+    f64 add_time; /* Time of adding the circles to the box (part of the placement time, in sec) */
+    f64 query_time; /* Total time of the feasibility queries in the filled box (in sec) */
+};
+typedef struct Bench_result Bench_result_t;
+
+static void
+print_usage_and_exit(char *program_name)
+{
+    /* Function to print the command line usage and exit the program */
+    printf("Usage: %s [options]\n", program_name);
+    printf("  --attempts N   number of the random placement attempts (default 20000)\n");
+    printf("  --queries N    number of the random queries in the filled box (default 1000000)\n");
+    printf("  --rmin N       smallest radius of the circles (default 1)\n");
+    printf("  --rmax N       largest radius of the circles (default 200)\n");
+    printf("  --size N       outer width and height of the box (default 2000)\n");
+    printf("  --seed N       seed of the random numbers (default 1)\n");
+    printf("  --check-kernels  compare the SIMD overlap kernels with the scalar one (exit code 2 if differ)\n");
+    exit(1);
+}
+
+static u32
+parse_u32_option(int argc, char **argv, int *i)
+{
+    /* Function to parse the unsigned value following the option argv[*i] */
+    char *end;
+    unsigned long value;
+
+    if (*i + 1 >= argc) print_usage_and_exit(argv[0]);
+    *i += 1;
+    value = strtoul(argv[*i], &end, 10);
+    if ((*end != '\0') || (end == argv[*i])) print_usage_and_exit(argv[0]);
+    return (u32)value;
+}
+
+static void
+parse_options(int argc, char **argv, Bench_options_t *options)
+{
+    /* Function to parse the command line options */
+    int i;
+    char *end;
+
+    options->attempts = 20000;
+    options->queries = 1000000;
+    options->r_min = 1;
+    options->r_max = 200;
+    options->size = 2000;
+    options->seed = 1;
+    options->is_kernels_check = false;
+
+    for (i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--attempts") == 0) {
+            options->attempts = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--queries") == 0) {
+            options->queries = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--rmin") == 0) {
+            options->r_min = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--rmax") == 0) {
+            options->r_max = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--size") == 0) {
+            options->size = parse_u32_option(argc, argv, &i);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            if (i + 1 >= argc) print_usage_and_exit(argv[0]);
+            i += 1;
+            options->seed = strtoull(argv[i], &end, 10);
+            if ((*end != '\0') || (end == argv[i])) print_usage_and_exit(argv[0]);
+        }
+        else if (strcmp(argv[i], "--check-kernels") == 0) {
+            options->is_kernels_check = true;
+        }
+        else {
+            print_usage_and_exit(argv[0]);
+        }
+    }
+
+    if ((options->r_min == 0) || (options->r_min > options->r_max) ||
+        (options->size < 2 * options->r_max + 3 * BENCH_WALL_WIDTH) ||
+        !box_size_is_valid(options->size, options->size, BENCH_WALL_WIDTH)) {
+        print_usage_and_exit(argv[0]);
+    }
+}
+
+static f64
+get_time_sec(void)
+{
+    /* Function to get the monotonic time in seconds */
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (f64)ts.tv_sec + (f64)ts.tv_nsec * 1.0e-9;
+}
+
+static void
+bench_random_circle(const Bench_options_t *options, const Box_t *box, Rng_t *rng, V2_u32_t *center,
+                    u32 *radius)
+{
+    /* Function to generate the random circle inside the box with the log-uniform distribution of
+       the radiuses */
+    *radius = (u32)lroundf((f32)options->r_min *
+                           powf((f32)options->r_max / (f32)options->r_min, rng_f32(rng)));
+    center->x = box->BL_in.x + *radius + rng_u32(rng) % (box->width_in - 2 * *radius + 1);
+    center->y = box->BL_in.y + *radius + rng_u32(rng) % (box->height_in - 2 * *radius + 1);
+}
+
+static Bench_result_t
+bench_run(const Bench_options_t *options, const Box_index_t index_type,
+          Circle_record_t *records)
+{
+    /* Function to run the random sequential addition of the circles into the box with the index
+       backend (the placed circles are stored to the records array), then the random feasibility
+       queries in the filled box */
+    Bench_result_t result = {0};
+    Box_t *box;
+    Rng_t rng;
+    V2_u32_t center;
+    V2_u32_t origin = {0};
+    u32 i, radius;
+    f64 begin_time, place_begin_time;
+
+    box = box_create(options->r_min, options->r_max, index_type);
+    box_init(box, origin, options->size, options->size, BENCH_WALL_WIDTH, 0x000000, 0x000000);
+    rng_seed(&rng, options->seed, 0);
+
+    place_begin_time = get_time_sec();
+    for (i = 0; i < options->attempts; ++i) {
+        bench_random_circle(options, box, &rng, &center, &radius);
+        if (!box_index_is_feasible(box, center.x, center.y, radius)) {
+            continue;
+        }
+
+        records[result.placed_num].x = center.x;
+        records[result.placed_num].y = center.y;
+        records[result.placed_num].radius = radius;
+        records[result.placed_num].index = result.placed_num;
+        result.checksum = result.checksum * 31 + (u64)center.x * 65536 + (u64)center.y * 256 + radius;
+        result.placed_num += 1;
+
+        begin_time = get_time_sec();
+        box_add_circle(box, center, radius, 0xffffff);
+        result.add_time += get_time_sec() - begin_time;
+    }
+    result.place_time = get_time_sec() - place_begin_time;
+
+    /* Queries of the filled box (the most of them are infeasible) */
+    rng_seed(&rng, options->seed, 1);
+    begin_time = get_time_sec();
+    for (i = 0; i < options->queries; ++i) {
+        bench_random_circle(options, box, &rng, &center, &radius);
+        if (box_index_is_feasible(box, center.x, center.y, radius)) {
+            result.feasible_num += 1;
+        }
+    }
+    result.query_time = get_time_sec() - begin_time;
+
+    box_delete(box);
+    return result;
+}
+
+static s32
+check_coordinate(const s64 value)
+{
+    /* Function to clamp the coordinate of the circle of the check to the box range 0...2^30 - 1 */
+    if (value < 0) return 0;
+    if (value >= (1 << 30)) return (1 << 30) - 1;
+    return (s32)value;
+}
+
+static u32
+check_kernels_random(const Bench_options_t *options, s32 *xs, s32 *ys, s32 *rs, u64 *mismatches)
+{
+    /* Function to compare the overlap kernels with the scalar one on the random lanes. A lane has
+       1...BENCH_CHECK_MAX_CIRCLES circles and is padded to the multiple of OVERLAP_LANE_WIDTH by the
+       far circles as in the box cells, so the lanes of 8, 24 or 40 elements also test the last 8
+       circles of the AVX2 kernel. The circles are scattered around the tested one with the random
+       scale up to 2^29 (coordinates below 2^30), so the lanes with and without the interception are
+       both frequent. Returns the number of the intercepting lanes */
+    Rng_t rng;
+    u32 i, k, m, n, scale, intercepting_num;
+    s32 x0, y0, r0;
+    b32 expected;
+    Overlap_kernel_t kernel;
+
+    rng_seed(&rng, options->seed, 2);
+    intercepting_num = 0;
+    for (i = 0; i < BENCH_CHECK_LANES; ++i) {
+        m = 1 + rng_u32(&rng) % BENCH_CHECK_MAX_CIRCLES;
+        n = (m + OVERLAP_LANE_WIDTH - 1) / OVERLAP_LANE_WIDTH * OVERLAP_LANE_WIDTH;
+        scale = 1u << (rng_u32(&rng) % 30);
+        x0 = (s32)(rng_u32(&rng) % (1u << 30));
+        y0 = (s32)(rng_u32(&rng) % (1u << 30));
+        r0 = (s32)(rng_u32(&rng) % (scale / 5 + 1));
+        for (k = 0; k < n; ++k) {
+            if (k < m) {
+                xs[k] = check_coordinate((s64)x0 + (s64)(rng_u32(&rng) % (2 * scale + 1)) - (s64)scale);
+                ys[k] = check_coordinate((s64)y0 + (s64)(rng_u32(&rng) % (2 * scale + 1)) - (s64)scale);
+                rs[k] = (s32)(rng_u32(&rng) % (scale / 5 + 1));
+            }
+            else {
+                xs[k] = OVERLAP_FAR_COORDINATE;
+                ys[k] = OVERLAP_FAR_COORDINATE;
+                rs[k] = 0;
+            }
+        }
+
+        expected = overlap_any_with(OVERLAP_KERNEL_SCALAR, xs, ys, rs, n, x0, y0, r0);
+        if (expected) intercepting_num += 1;
+        for (kernel = OVERLAP_KERNEL_SSE2; kernel < OVERLAP_KERNELS_NUM; ++kernel) {
+            if (overlap_kernel_is_supported(kernel) &&
+                (overlap_any_with(kernel, xs, ys, rs, n, x0, y0, r0) != expected)) {
+                mismatches[kernel] += 1;
+            }
+        }
+    }
+    return intercepting_num;
+}
+
+static u32
+check_kernels_boundary(s32 *xs, s32 *ys, s32 *rs, u64 *errors)
+{
+    /* Function to check all the kernels (the scalar one too) on the boundary cases. The circle of
+       the case is put at every position of the lanes of 8, 16 and 24 elements (the rest is the far
+       padding), so it gets into every SIMD lane and into the last 8 circles of the AVX2 kernel.
+       Returns the number of the checked lanes */
+    u32 c, k, p, n, lanes_num;
+    const Bench_overlap_case_t *test;
+    Overlap_kernel_t kernel;
+
+    lanes_num = 0;
+    for (c = 0; c < sizeof(BENCH_OVERLAP_CASES) / sizeof(BENCH_OVERLAP_CASES[0]); ++c) {
+        test = &BENCH_OVERLAP_CASES[c];
+        for (n = OVERLAP_LANE_WIDTH; n <= 3 * OVERLAP_LANE_WIDTH; n += OVERLAP_LANE_WIDTH) {
+            for (p = 0; p < n; ++p) {
+                for (k = 0; k < n; ++k) {
+                    xs[k] = (k == p) ? test->x : OVERLAP_FAR_COORDINATE;
+                    ys[k] = (k == p) ? test->y : OVERLAP_FAR_COORDINATE;
+                    rs[k] = (k == p) ? test->r : 0;
+                }
+                for (kernel = OVERLAP_KERNEL_SCALAR; kernel < OVERLAP_KERNELS_NUM; ++kernel) {
+                    if (overlap_kernel_is_supported(kernel) &&
+                        (overlap_any_with(kernel, xs, ys, rs, n, test->x0, test->y0, test->r0) !=
+                         test->is_intercepting)) {
+                        errors[kernel] += 1;
+                    }
+                }
+                lanes_num += 1;
+            }
+        }
+    }
+    return lanes_num;
+}
+
+static b32
+check_kernels(const Bench_options_t *options)
+{
+    /* Function to compare the SIMD overlap kernels with the scalar one and to check all of them on
+       the boundary cases. Returns false if any of the supported kernels gives the wrong result */
+    s32 *xs, *ys, *rs;
+    u64 mismatches[OVERLAP_KERNELS_NUM] = {0};
+    u64 errors[OVERLAP_KERNELS_NUM] = {0};
+    u32 intercepting_num, boundary_lanes_num;
+    Overlap_kernel_t kernel;
+    b32 is_matched = true;
+
+    xs = (s32 *) aligned_memory_alloc(BENCH_CHECK_LANE_SIZE * sizeof(s32), BENCH_LANE_ALIGNMENT);
+    ys = (s32 *) aligned_memory_alloc(BENCH_CHECK_LANE_SIZE * sizeof(s32), BENCH_LANE_ALIGNMENT);
+    rs = (s32 *) aligned_memory_alloc(BENCH_CHECK_LANE_SIZE * sizeof(s32), BENCH_LANE_ALIGNMENT);
+
+    intercepting_num = check_kernels_random(options, xs, ys, rs, mismatches);
+    boundary_lanes_num = check_kernels_boundary(xs, ys, rs, errors);
+    printf("Overlap kernels: %u random lanes (%u intercepting), %u boundary lanes, seed: %llu\n",
+           BENCH_CHECK_LANES, intercepting_num, boundary_lanes_num, (unsigned long long)options->seed);
+    for (kernel = OVERLAP_KERNEL_SCALAR; kernel < OVERLAP_KERNELS_NUM; ++kernel) {
+        if (!overlap_kernel_is_supported(kernel)) {
+            printf("%-7s not supported\n", BENCH_KERNEL_NAMES[kernel]);
+            continue;
+        }
+        if (kernel == OVERLAP_KERNEL_SCALAR) {
+            printf("%-7s reference, boundary errors: %llu\n", BENCH_KERNEL_NAMES[kernel],
+                   (unsigned long long)errors[kernel]);
+        }
+        else {
+            printf("%-7s mismatches with scalar: %llu, boundary errors: %llu\n", BENCH_KERNEL_NAMES[kernel],
+                   (unsigned long long)mismatches[kernel], (unsigned long long)errors[kernel]);
+        }
+        if ((mismatches[kernel] > 0) || (errors[kernel] > 0)) is_matched = false;
+    }
+
+    aligned_memory_free(rs);
+    aligned_memory_free(ys);
+    aligned_memory_free(xs);
+    return is_matched;
+}
+
+static void
+print_result(const char *name, const Bench_options_t *options, const Bench_result_t *result)
+{
+    /* Function to print the results of the benchmark of one backend */
+    printf("%-9s placed %6u  placement %9.3f ms (add with clearance %9.3f ms)  feasible %7u  "
+           "query %8.3f ms (%6.1f ns / query)\n", name, result->placed_num, result->place_time * 1.0e3,
+           result->add_time * 1.0e3, result->feasible_num, result->query_time * 1.0e3,
+           (options->queries > 0) ? result->query_time * 1.0e9 / (f64)options->queries : 0.0);
+}
+
+/* Entry point for the index benchmark */
+int
+main(int argc, char **argv)
+{
+    Bench_options_t options;
+    Circle_record_t *records;
+    Bench_result_t grid_result, quadtree_result;
+    Quadtree_t *quadtree, *bulk_quadtree;
+    f64 begin_time, insert_time, build_time;
+    u32 i;
+
+    parse_options(argc, argv, &options);
+
+    if (options.is_kernels_check) {
+        return check_kernels(&options) ? 0 : 2;
+    }
+
+    records = (Circle_record_t *) calloc ((size_t)options.attempts + 1, sizeof(Circle_record_t));
+    if (NULL == records) print_error_and_exit("Error in memory allocation!\n");
+
+    printf("Attempts: %u, radiuses: %u..%u (log-uniform), box: %u x %u, seed: %llu\n", options.attempts,
+           options.r_min, options.r_max, options.size, options.size, (unsigned long long)options.seed);
+
+    /* Both backends should give the same placements, only the time is different */
+    grid_result = bench_run(&options, BOX_INDEX_GRID, records);
+    quadtree_result = bench_run(&options, BOX_INDEX_QUADTREE, records);
+    print_result("grid", &options, &grid_result);
+    print_result("quadtree", &options, &quadtree_result);
+    printf("Results match: %s\n", ((grid_result.placed_num == quadtree_result.placed_num) &&
+                                   (grid_result.checksum == quadtree_result.checksum) &&
+                                   (grid_result.feasible_num == quadtree_result.feasible_num)) ? "yes" : "NO");
+
+    /* Incremental insert against the bulk build of the quadtree from the placed circles */
+    quadtree = quadtree_create();
+    quadtree_init(quadtree, 0, 0, options.size, options.size, 4);
+    begin_time = get_time_sec();
+    for (i = 0; i < quadtree_result.placed_num; ++i) {
+        quadtree_insert(quadtree, &records[i]);
+    }
+    insert_time = get_time_sec() - begin_time;
+
+    bulk_quadtree = quadtree_create();
+    quadtree_init(bulk_quadtree, 0, 0, options.size, options.size, 4);
+    begin_time = get_time_sec();
+    quadtree_build(bulk_quadtree, records, quadtree_result.placed_num);
+    build_time = get_time_sec() - begin_time;
+    printf("Quadtree of %u circles: incremental insert %.3f ms, bulk build %.3f ms (%u nodes)\n",
+           quadtree_result.placed_num, insert_time * 1.0e3, build_time * 1.0e3, bulk_quadtree->nodes_num);
+
+    quadtree_delete(bulk_quadtree);
+    quadtree_delete(quadtree);
+    free(records);
+    return 0;
+}
@@ -8,6 +8,9 @@
 #include <stdlib.h>
 #include <math.h>
 #include <stdio.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 /* Program includes: */
 #include <utils.h>
@@ -25,31 +28,6 @@ trim(f32 value, f32 low_bnd, f32 hight_bnd)
     return value;
 }
 
-u32
-rnd_int_range(u32 left_bnd, u32 right_bnd)
-{
-    /* Function for generation random u32 number from the specific range */
-    return (left_bnd + (rand() % (right_bnd - left_bnd)));
-}
-
-f32
-rnd_f32(void)
-{
-    /* Function to generate the random number in range [0.0, 1.0) */
-    f32 result;
-    result = (f32)((rand() % 32767) / (f32)32767);
-    return result;
-}
-
-f32
-rnd_f32_range(f32 left_bnd, f32 right_bnd)
-{
-    /* Function for generation random f32 number from specific range */
-    f32 result;
-    result = left_bnd + rnd_f32() * (right_bnd - left_bnd);
-    return result;
-}
-
 void
 print_error_and_exit(char *text)
 {
@@ -103,6 +81,56 @@ dynamic_2d_f32_array_free(f32 **array, u32 N)
     free(array);	
 }
 
+void*
+aligned_memory_alloc(size_t size, size_t alignment)
+{
+    /* Function for dynamic allocation of the memory aligned by the alignment (power of two). The
+       size is rounded up to the multiple of the alignment (required by aligned_alloc). The memory
+       should be released by aligned_memory_free */
+
+    void *memory;
+
+    size = (size + alignment - 1) / alignment * alignment;
+    if (size == 0) size = alignment;
+#ifdef _WIN32
+    memory = _aligned_malloc (size, alignment);
+#else
+    memory = aligned_alloc (alignment, size);
+#endif
+    if (NULL == memory) print_error_and_exit("Error in memory allocation!\n");
+    return memory;
+}
+
+void
+aligned_memory_free(void *memory)
+{
+    /* Function for memory free of the memory allocated by aligned_memory_alloc */
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+f32*
+dynamic_1d_f32_aligned_alloc(u32 N)
+{
+    /* Function for dynamic allocation of 1d array of f32 elements aligned by 32 bytes (suitable
+       for the SSE and AVX loads). The allocated size is rounded up to the multiple of 8 elements.
+       N - number of elements */
+
+    size_t size = (((size_t)N + 7) / 8) * 8 * sizeof(f32);
+
+    return (f32 *) aligned_memory_alloc (size, 32);
+}
+
+void
+dynamic_1d_f32_aligned_free(f32 *array)
+{
+    /* Function for memory free of the aligned 1d array */
+    aligned_memory_free(array);
+}
+
 b32
 rectangles_are_collide(V2_u32_t BL_1, V2_u32_t UR_1, V2_u32_t BL_2, V2_u32_t UR_2)
 {
@@ -118,3 +146,31 @@ rectangles_are_collide(V2_u32_t BL_1, V2_u32_t UR_1, V2_u32_t BL_2, V2_u32_t UR_
     }
     return true;
 }
+
+u32
+isqrt_u32(u32 n)
+{
+    /* Function for the exact integer square root (the largest s with s * s <= n). The floating
+       point estimation is corrected in the integer arithmetics */
+    u64 s;
+
+    s = (u64)sqrt((f64)n);
+    while (s * s > (u64)n) s -= 1;
+    while ((s + 1) * (s + 1) <= (u64)n) s += 1;
+    return (u32)s;
+}
+
+u64
+isqrt_u64(u64 n)
+{
+    /* Function for the exact integer square root of the 64-bit number (the largest s with
+       s * s <= n). The double estimation has less bits than n, so it is corrected in both
+       directions (the products are below 2^64 for s < 2^32) */
+    u64 s;
+
+    s = (u64)sqrt((f64)n);
+    if (s > 0xffffffffu) s = 0xffffffffu;
+    while (s * s > n) s -= 1;
+    while ((s < 0xffffffffu) && ((s + 1) * (s + 1) <= n)) s += 1;
+    return s;
+}
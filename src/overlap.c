@@ -0,0 +1,236 @@
+/*================================================================================*/
+/* Realization of the overlap kernels                                             */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <assert.h>
+#include <pthread.h>
+
+/* Program includes: */
+#include <overlap.h>
+#include <utils.h>
+
+/* x86 SIMD kernels are compiled with the target attributes and selected at runtime */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define OVERLAP_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* Type of the overlap kernel */
+typedef b32 (*Overlap_any_fn_t)(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0,
+                                const s32 y0, const s32 r0);
+
+static b32
+overlap_any_scalar(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0, const s32 y0,
+                   const s32 r0)
+{
+    /* Kernel to check the interception of the circle with the circles of the lanes (one circle per
+       step). Squared distances are compared in 64-bit integers */
+
+    u32 i;
+    s64 dx, dy, s;
+
+    for (i = 0; i < n; ++i) {
+        dx = (s64)xs[i] - (s64)x0;
+        dy = (s64)ys[i] - (s64)y0;
+        s = (s64)rs[i] + (s64)r0;
+        if (dx * dx + dy * dy <= s * s) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/* Kernel used by overlap_any (the fastest supported one after the selection, written only once by
+   overlap_select_kernels_once) */
+static Overlap_any_fn_t overlap_any_kernel = overlap_any_scalar;
+static pthread_once_t overlap_kernels_once = PTHREAD_ONCE_INIT;
+
+#ifdef OVERLAP_X86_KERNELS
+__attribute__((target("sse2"))) static __m128i
+overlap_slack_sse(const __m128i dx, const __m128i dy, const __m128i s)
+{
+    /* Function to calculate (r + r0)^2 - d^2 of 4 circles as 2 x 2 64-bit integers (even lanes and
+       odd lanes, in the low and high halves of the result). The slack is negative for the circle
+       without the interception. dx, dy are the absolute differences, s is the sum of the radiuses */
+
+    __m128i even, odd;
+    __m128i dx_odd = _mm_srli_epi64(dx, 32);
+    __m128i dy_odd = _mm_srli_epi64(dy, 32);
+    __m128i s_odd = _mm_srli_epi64(s, 32);
+
+    even = _mm_sub_epi64(_mm_mul_epu32(s, s), _mm_add_epi64(_mm_mul_epu32(dx, dx), _mm_mul_epu32(dy, dy)));
+    odd = _mm_sub_epi64(_mm_mul_epu32(s_odd, s_odd),
+                        _mm_add_epi64(_mm_mul_epu32(dx_odd, dx_odd), _mm_mul_epu32(dy_odd, dy_odd)));
+
+    /* Sign of the AND is negative only if both slacks are negative */
+    return _mm_and_si128(even, odd);
+}
+
+__attribute__((target("sse2"))) static __m128i
+overlap_abs_sse(const __m128i v)
+{
+    /* Function to calculate the absolute values of 4 32-bit integers (SSE2 has no abs instruction) */
+    __m128i sign = _mm_srai_epi32(v, 31);
+    return _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+}
+
+__attribute__((target("sse2"))) static b32
+overlap_any_sse(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0, const s32 y0,
+                const s32 r0)
+{
+    /* SSE version of the overlap kernel (2 x 4 circles per step, n is multiple of 8). The squares of
+       the absolute differences are calculated by the unsigned 32 x 32 -> 64-bit multiplications */
+
+    u32 i;
+    __m128i dx, dy, s, slack_lo, slack_hi;
+    const __m128i vx = _mm_set1_epi32(x0);
+    const __m128i vy = _mm_set1_epi32(y0);
+    const __m128i vr = _mm_set1_epi32(r0);
+
+    for (i = 0; i < n; i += 8) {
+        dx = overlap_abs_sse(_mm_sub_epi32(_mm_load_si128((const __m128i *)(xs + i)), vx));
+        dy = overlap_abs_sse(_mm_sub_epi32(_mm_load_si128((const __m128i *)(ys + i)), vy));
+        s = _mm_add_epi32(_mm_load_si128((const __m128i *)(rs + i)), vr);
+        slack_lo = overlap_slack_sse(dx, dy, s);
+
+        dx = overlap_abs_sse(_mm_sub_epi32(_mm_load_si128((const __m128i *)(xs + i + 4)), vx));
+        dy = overlap_abs_sse(_mm_sub_epi32(_mm_load_si128((const __m128i *)(ys + i + 4)), vy));
+        s = _mm_add_epi32(_mm_load_si128((const __m128i *)(rs + i + 4)), vr);
+        slack_hi = overlap_slack_sse(dx, dy, s);
+
+        /* Any non-negative slack is the interception */
+        if (_mm_movemask_pd(_mm_castsi128_pd(_mm_and_si128(slack_lo, slack_hi))) != 0x3) {
+            return true;
+        }
+    }
+    return false;
+}
+
+__attribute__((target("avx2"))) static __m256i
+overlap_slack_avx2(const __m256i dx, const __m256i dy, const __m256i s)
+{
+    /* AVX2 version of the slack of 8 circles as 2 x 4 64-bit integers (see overlap_slack_sse) */
+
+    __m256i even, odd;
+    __m256i dx_odd = _mm256_srli_epi64(dx, 32);
+    __m256i dy_odd = _mm256_srli_epi64(dy, 32);
+    __m256i s_odd = _mm256_srli_epi64(s, 32);
+
+    even = _mm256_sub_epi64(_mm256_mul_epu32(s, s),
+                            _mm256_add_epi64(_mm256_mul_epu32(dx, dx), _mm256_mul_epu32(dy, dy)));
+    odd = _mm256_sub_epi64(_mm256_mul_epu32(s_odd, s_odd),
+                           _mm256_add_epi64(_mm256_mul_epu32(dx_odd, dx_odd), _mm256_mul_epu32(dy_odd, dy_odd)));
+    return _mm256_and_si256(even, odd);
+}
+
+__attribute__((target("avx2"))) static b32
+overlap_any_avx2(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0, const s32 y0,
+                 const s32 r0)
+{
+    /* AVX2 version of the overlap kernel (2 x 8 circles per step, n is multiple of 8) */
+
+    u32 i;
+    __m256i dx, dy, s, slack_lo, slack_hi;
+    const __m256i vx = _mm256_set1_epi32(x0);
+    const __m256i vy = _mm256_set1_epi32(y0);
+    const __m256i vr = _mm256_set1_epi32(r0);
+
+    for (i = 0; i + 16 <= n; i += 16) {
+        dx = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(xs + i)), vx));
+        dy = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(ys + i)), vy));
+        s = _mm256_add_epi32(_mm256_load_si256((const __m256i *)(rs + i)), vr);
+        slack_lo = overlap_slack_avx2(dx, dy, s);
+
+        dx = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(xs + i + 8)), vx));
+        dy = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(ys + i + 8)), vy));
+        s = _mm256_add_epi32(_mm256_load_si256((const __m256i *)(rs + i + 8)), vr);
+        slack_hi = overlap_slack_avx2(dx, dy, s);
+
+        if (_mm256_movemask_pd(_mm256_castsi256_pd(_mm256_and_si256(slack_lo, slack_hi))) != 0xf) {
+            return true;
+        }
+    }
+
+    /* Last 8 circles */
+    if (i < n) {
+        dx = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(xs + i)), vx));
+        dy = _mm256_abs_epi32(_mm256_sub_epi32(_mm256_load_si256((const __m256i *)(ys + i)), vy));
+        s = _mm256_add_epi32(_mm256_load_si256((const __m256i *)(rs + i)), vr);
+        slack_lo = overlap_slack_avx2(dx, dy, s);
+        if (_mm256_movemask_pd(_mm256_castsi256_pd(slack_lo)) != 0xf) {
+            return true;
+        }
+    }
+    return false;
+}
+#endif /* OVERLAP_X86_KERNELS */
+
+/* Kernels by their type (NULL - not compiled for the target) */
+#ifdef OVERLAP_X86_KERNELS
+static const Overlap_any_fn_t overlap_kernels[OVERLAP_KERNELS_NUM] = {
+    overlap_any_scalar, overlap_any_sse, overlap_any_avx2
+};
+#else
+static const Overlap_any_fn_t overlap_kernels[OVERLAP_KERNELS_NUM] = {overlap_any_scalar, NULL, NULL};
+#endif
+
+static void
+overlap_select_kernels_once(void)
+{
+    /* Function to select the fastest overlap kernel supported by the CPU */
+    if (overlap_kernel_is_supported(OVERLAP_KERNEL_AVX2)) {
+        overlap_any_kernel = overlap_kernels[OVERLAP_KERNEL_AVX2];
+    }
+    else if (overlap_kernel_is_supported(OVERLAP_KERNEL_SSE2)) {
+        overlap_any_kernel = overlap_kernels[OVERLAP_KERNEL_SSE2];
+    }
+}
+
+void
+overlap_select_kernels(void)
+{
+    /* Function to select the overlap kernel before the first use. The boxes are created by several
+       threads (ensemble runs), so the selection is done only once for all of them */
+    pthread_once(&overlap_kernels_once, overlap_select_kernels_once);
+}
+
+b32
+overlap_any(const s32 *xs, const s32 *ys, const s32 *rs, const u32 n, const s32 x0, const s32 y0,
+            const s32 r0)
+{
+    /* Function to check the interception of the circle with any circle of the lanes by the
+       selected kernel */
+    return overlap_any_kernel(xs, ys, rs, n, x0, y0, r0);
+}
+
+b32
+overlap_kernel_is_supported(const Overlap_kernel_t kernel)
+{
+    /* Function to check if the kernel is compiled for the target and supported by the CPU */
+    switch (kernel) {
+    case OVERLAP_KERNEL_SCALAR:
+        return true;
+#ifdef OVERLAP_X86_KERNELS
+    case OVERLAP_KERNEL_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2") != 0;
+    case OVERLAP_KERNEL_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#endif
+    default:
+        return false;
+    }
+}
+
+b32
+overlap_any_with(const Overlap_kernel_t kernel, const s32 *xs, const s32 *ys, const s32 *rs, const u32 n,
+                 const s32 x0, const s32 y0, const s32 r0)
+{
+    /* Function to check the interception of the circle with any circle of the lanes by the given
+       kernel (it should be supported, see overlap_kernel_is_supported) */
+    assert(overlap_kernel_is_supported(kernel));
+    return overlap_kernels[kernel](xs, ys, rs, n, x0, y0, r0);
+}
@@ -0,0 +1,423 @@
+/*================================================================================*/
+/* Realization of packing methods                                                 */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <stdio.h>
+
+/* Program includes: */
+#include <packing.h>
+#include <packing_params.h>
+#include <utils.h>
+#include <world.h>
+#include <box.h>
+#include <circle.h>
+#include <pso_algorithm.h>
+#include <misc.h>
+#include <thread_pool.h>
+#include <rng.h>
+#include <contact_engine.h>
+
+/* Job of the concurrent searches of the speculative batch */
+struct Packing_job {
+    Packing_t *packing; /* Packing with the searched batch */
+    const u32 *indices; /* Indices of the slots to search (one per task) */
+};
+typedef struct Packing_job Packing_job_t;
+
+/* Static functions */
+/* Function to search and commit the next batch of the circles */
+static void packing_speculate(Packing_t *packing);
+/* Function to search the positions of the slots in parallel (or serially without the pool) */
+static void packing_search_slots(Packing_t *packing, const u32 *indices, const u32 indices_num);
+/* Task of the thread pool: search of the position of one slot */
+static void packing_search_task(void *task_ctx, u32 task_index);
+/* Function to add the statistics of the PSO search */
+static void packing_add_search_stats(Packing_t *packing, const PSO_result_t *result);
+/* Function to push the event of the placed circle into the placement log */
+static void packing_log_placement(Packing_t *packing, const Circle_t *circle, const u32 iterations);
+
+Packing_t*
+packing_create(const Packing_engine_t engine, const Box_index_t index_type, const u32 n_pop,
+               const u32 n_islands, const u32 threads_num)
+{
+    /* Method for creation of the packing object with the placement engine and the spatial index of
+       the box. PSO engine uses n_islands swarms of n_pop particles and threads_num additional
+       worker threads (malloc) */
+    Packing_t *tmp_packing;
+    u32 i, min_radius, max_radius;
+
+    tmp_packing = (Packing_t *) calloc (1, sizeof(Packing_t));
+    if (NULL == tmp_packing) print_error_and_exit("Error in memory allocation!\n");
+
+    /* Box keeps the clearance for the circles up to the largest radius and the open tiles for the
+       smallest one */
+    min_radius = CIRCLES_RADIUSES[0];
+    max_radius = 0;
+    for (i = 0; i < CIRCLES_TYPES; ++i) {
+        if (CIRCLES_RADIUSES[i] < min_radius) min_radius = CIRCLES_RADIUSES[i];
+        if (CIRCLES_RADIUSES[i] > max_radius) max_radius = CIRCLES_RADIUSES[i];
+    }
+
+    tmp_packing->engine = engine;
+    tmp_packing->box = box_create(min_radius, max_radius, index_type);
+    box_set_subpixel(tmp_packing->box, BOX_USE_SUBPIXEL);
+    tmp_packing->box_width_out = BOX_WIDTH_OUT;
+    tmp_packing->box_height_out = BOX_HEIGHT_OUT;
+
+    if (engine == PACKING_ENGINE_CONTACT) {
+        /* Candidates are kept by the box for all the radiuses of the circles */
+        box_set_contact_engine(tmp_packing->box, contact_engine_create(CIRCLES_RADIUSES, CIRCLES_TYPES));
+        return tmp_packing;
+    }
+
+    tmp_packing->pso = pso_create(PSO_N_VAR, n_pop, n_islands);
+    if (threads_num > 0) {
+        tmp_packing->thread_pool = thread_pool_create(threads_num);
+    }
+    packing_set_speculation(tmp_packing, PSO_SPECULATION_NUM);
+
+    return tmp_packing;
+}
+
+void
+packing_delete(Packing_t *packing)
+{
+    /* Method for deleting the packing object */
+    u32 k;
+
+    if (NULL != packing->pso) {
+        for (k = 1; k < packing->speculation_num; ++k) {
+            pso_delete(packing->psos[k]);
+        }
+        pso_delete(packing->pso);
+        free(packing->psos);
+        free(packing->slots);
+        free(packing->search_indices);
+    }
+    if (NULL != packing->thread_pool) {
+        thread_pool_delete(packing->thread_pool);
+    }
+    box_delete(packing->box);
+    free(packing);
+}
+
+void
+packing_set_box_size(Packing_t *packing, const u32 box_width_out, const u32 box_height_out)
+{
+    /* Method to set the outer size of the box. The box does not depend on the window, so it can be
+       much larger than the world (then it is placed at the origin). Used by the next initialization */
+    packing->box_width_out = box_width_out;
+    packing->box_height_out = box_height_out;
+}
+
+void
+packing_set_placement_log(Packing_t *packing, Placement_log_t *placement_log)
+{
+    /* Method to set the log of the placed circles. The events are pushed by the placement thread
+       right after the circle is added to the box */
+    packing->placement_log = placement_log;
+}
+
+void
+packing_set_speculation(Packing_t *packing, const u32 speculation_num)
+{
+    /* Method to set the number of the circles searched concurrently by the PSO engine. Every
+       concurrent search has its own PSO object, the thread pool runs the searches instead of the
+       islands or the particles of one search. Ignored by the contact engine (malloc) */
+    u32 k;
+
+    if ((NULL == packing->pso) || (0 == speculation_num)) {
+        return;
+    }
+
+    for (k = 1; k < packing->speculation_num; ++k) {
+        pso_delete(packing->psos[k]);
+    }
+    free(packing->psos);
+    free(packing->slots);
+    free(packing->search_indices);
+
+    packing->speculation_num = speculation_num;
+    packing->psos = (PSO_t **) calloc (speculation_num, sizeof(PSO_t *));
+    packing->slots = (Packing_slot_t *) calloc (speculation_num, sizeof(Packing_slot_t));
+    packing->search_indices = (u32 *) calloc (speculation_num, sizeof(u32));
+    if ((NULL == packing->psos) || (NULL == packing->slots) || (NULL == packing->search_indices)) {
+        print_error_and_exit("Error in memory allocation!\n");
+    }
+
+    packing->psos[0] = packing->pso;
+    for (k = 1; k < speculation_num; ++k) {
+        packing->psos[k] = pso_create(PSO_N_VAR, packing->pso->n_pop, packing->pso->n_islands);
+    }
+    pso_set_thread_pool(packing->pso, (speculation_num > 1) ? NULL : packing->thread_pool);
+}
+
+void
+packing_init(Packing_t *packing, World_t *world, const u32 text_panel_height, const u64 seed)
+{
+    /* Initialization (reset) of the packing object and its box and pso objects. The box fitting
+       into the world is placed in its middle above the text panel, otherwise (or without the
+       world) at the origin. Stream 0 of the seed is used for the circles parameters, the next
+       streams are used by the PSO islands (of all the concurrent searches one after another) */
+
+    V2_u32_t BL_out = {0};
+    PSO_t *pso;
+    u32 k;
+
+    if ((NULL != world) && (packing->box_width_out <= world->width) &&
+        (packing->box_height_out + text_panel_height <= world->height)) {
+        BL_out.x = (world->width - packing->box_width_out) / 2;
+        BL_out.y = (world->height - packing->box_height_out - text_panel_height) / 3;
+    }
+    box_init(packing->box, BL_out, packing->box_width_out, packing->box_height_out, BOX_WALL_WIDTH,
+             BOX_WALL_CLR, BOX_INTERIOR_CLR);
+
+    packing->seed = seed;
+    rng_seed(&packing->rng, seed, 0);
+
+    for (k = 0; (NULL != packing->pso) && (k < packing->speculation_num); ++k) {
+        pso = packing->psos[k];
+        pso_init(pso, PSO_VAR_MIN, PSO_VAR_MAX, PSO_USE_ITER_LIMIT, PSO_ITER_LIMIT, PSO_W_INIT, PSO_W_DAMP,
+                 PSO_C1, PSO_C2, PSO_A, PSO_B, PSO_MIGRATION_INTERVAL);
+        pso_set_early_termination(pso, PSO_STALL_LIMIT, PSO_SPREAD_TOL);
+        pso_set_warm_start(pso, PSO_WARM_FRACTION, PSO_WARM_SPREAD);
+        pso_set_surface_start(pso, PSO_SURFACE_FRACTION, PSO_SURFACE_SPREAD);
+        pso_set_pruning(pso, PSO_USE_PRUNING);
+        pso_set_open_sampling(pso, PSO_USE_OPEN_SAMPLING);
+        pso_seed(pso, seed, 1 + (u64)k * pso->n_islands);
+    }
+    packing->slots_num = 0;
+    packing->slots_next = 0;
+
+    packing->is_finished = false;
+    packing->searches_num = 0;
+    packing->iterations_num = 0;
+    packing->evaluations_num = 0;
+    packing->infeasible_num = 0;
+    packing->cache_hits = 0;
+    packing->cache_misses = 0;
+    packing->pruned_num = 0;
+    packing->conflicts_num = 0;
+}
+
+Circle_t*
+packing_step(Packing_t *packing)
+{
+    /* Method for placing one new circle into the box. The circle parameters are generated from the
+       probability distribution and the position is searched with the placement engine. Return the
+       pointer to the packed circle (owned by the box) or NULL when the search has failed */
+
+    PSO_result_t pso_result;
+    Circle_t *circle;
+    V2_u32_t position; /* Position (in the geometry units of the box) of the circle center */
+    u32 color, radius;
+    u32 iterations = 0; /* PSO iterations of the search (for the placement log) */
+
+    /* Circles of the speculative batch are returned one by one (they are already in the box) */
+    if (packing->speculation_num > 1) {
+        if ((packing->slots_next == packing->slots_num) && !packing->is_finished) {
+            packing_speculate(packing);
+        }
+        if (packing->slots_next == packing->slots_num) {
+            return NULL;
+        }
+        packing->slots_next += 1;
+        return packing->slots[packing->slots_next - 1].circle;
+    }
+
+    if (packing->is_finished) {
+        return NULL;
+    }
+
+    /* Even the smallest circle can't be placed into the box without the open tiles */
+    if (0 == packing->box->open_tiles_num) {
+        packing->is_finished = true;
+        return NULL;
+    }
+
+    /* Generate the parameters of a new circle */
+    circle_generate_params(&packing->rng, CIRCLES_TYPES, CIRCLES_PROB, CIRCLES_COL, CIRCLES_RADIUSES,
+                           &color, &radius);
+
+    /* The circle can't be placed if it is larger than the largest free place of the box */
+    if (radius > box_largest_radius(packing->box)) {
+        packing->is_finished = true;
+        return NULL;
+    }
+
+    /* Try to find the optimal position of the circle */
+    packing->searches_num += 1;
+    if (packing->engine == PACKING_ENGINE_CONTACT) {
+        if (!contact_engine_find(packing->box->contact_engine, radius, &position)) {
+            packing->is_finished = true;
+            return NULL;
+        }
+    }
+    else {
+        pso_result = pso_run_search(packing->pso, packing->box, radius);
+        packing_add_search_stats(packing, &pso_result);
+        iterations = pso_result.iterations;
+
+        if (!pso_result.is_solution_found) {
+            packing->is_finished = true;
+            return NULL;
+        }
+
+        /* PSO searches the pixels, in the sub-pixel mode the found center is settled closer to the
+           neighbours */
+        position.x = pso_result.global_best_coordinates.x << packing->box->subpixel_bits;
+        position.y = pso_result.global_best_coordinates.y << packing->box->subpixel_bits;
+        position = box_settle(packing->box, position, radius);
+    }
+
+    /* Create the circle and add it to the box */
+    circle = box_add_circle_at(packing->box, position, radius, color);
+    packing_log_placement(packing, circle, iterations);
+
+    return circle;
+}
+
+static void
+packing_speculate(Packing_t *packing)
+{
+    /* Function to place the next batch of speculation_num circles. The parameters of all the
+       circles are generated first, then the positions are searched concurrently against the same
+       state of the box. The results are committed in the order of the circles: the position
+       intercepting the earlier committed circle is searched again in the next round (together with
+       the other not committed circles without the result), the rest keep their results. The first
+       not committed circle is searched against the current box, so every round commits at least
+       one circle. The box fullness checks and the failed search finish the packing as for the
+       placement one by one */
+
+    Box_t *box = packing->box;
+    Packing_slot_t *slot;
+    u32 indices_num, first, k;
+    V2_u32_t position; /* Position (in the geometry units of the box) of the circle center */
+
+    packing->slots_num = 0;
+    packing->slots_next = 0;
+    for (k = 0; k < packing->speculation_num; ++k) {
+        slot = &packing->slots[k];
+        circle_generate_params(&packing->rng, CIRCLES_TYPES, CIRCLES_PROB, CIRCLES_COL, CIRCLES_RADIUSES,
+                               &slot->color, &slot->radius);
+        slot->is_searched = false;
+        slot->circle = NULL;
+    }
+
+    first = 0;
+    while (first < packing->speculation_num) {
+        /* Even the smallest circle can't be placed into the box without the open tiles, the circle
+           can't be placed if it is larger than the largest free place of the box */
+        if ((0 == box->open_tiles_num) || (packing->slots[first].radius > box_largest_radius(box))) {
+            packing->is_finished = true;
+            return;
+        }
+
+        indices_num = 0;
+        for (k = first; k < packing->speculation_num; ++k) {
+            if (!packing->slots[k].is_searched) {
+                packing->search_indices[indices_num] = k;
+                indices_num += 1;
+            }
+        }
+        packing_search_slots(packing, packing->search_indices, indices_num);
+
+        /* Commit the results in the order up to the first conflict */
+        for (k = first; k < packing->speculation_num; ++k) {
+            slot = &packing->slots[k];
+            if (!slot->result.is_solution_found) {
+                packing->is_finished = true;
+                return;
+            }
+            position.x = slot->result.global_best_coordinates.x << box->subpixel_bits;
+            position.y = slot->result.global_best_coordinates.y << box->subpixel_bits;
+            if (!box_is_feasible_at(box, position, slot->radius)) {
+                slot->is_searched = false;
+                packing->conflicts_num += 1;
+                break;
+            }
+            position = box_settle(box, position, slot->radius);
+            slot->circle = box_add_circle_at(box, position, slot->radius, slot->color);
+            packing_log_placement(packing, slot->circle, slot->result.iterations);
+            packing->slots_num += 1;
+            first = k + 1;
+
+            if ((first < packing->speculation_num) &&
+                ((0 == box->open_tiles_num) || (packing->slots[first].radius > box_largest_radius(box)))) {
+                packing->is_finished = true;
+                return;
+            }
+        }
+    }
+}
+
+static void
+packing_search_slots(Packing_t *packing, const u32 *indices, const u32 indices_num)
+{
+    /* Function to search the positions of the slots (every slot by its own PSO object). The box is
+       not modified during the searches, so they are run in parallel by the thread pool */
+
+    Packing_job_t job;
+    u32 i;
+
+    job.packing = packing;
+    job.indices = indices;
+    if (NULL != packing->thread_pool) {
+        thread_pool_run(packing->thread_pool, packing_search_task, &job, indices_num);
+    }
+    else {
+        for (i = 0; i < indices_num; ++i) {
+            packing_search_task(&job, i);
+        }
+    }
+
+    for (i = 0; i < indices_num; ++i) {
+        packing->slots[indices[i]].is_searched = true;
+        packing->searches_num += 1;
+        packing_add_search_stats(packing, &packing->slots[indices[i]].result);
+    }
+}
+
+static void
+packing_search_task(void *task_ctx, u32 task_index)
+{
+    /* Task of the thread pool: search of the position of one slot by its PSO object */
+    Packing_job_t *job = (Packing_job_t *)task_ctx;
+    Packing_t *packing = job->packing;
+    u32 k = job->indices[task_index];
+
+    packing->slots[k].result = pso_run_search(packing->psos[k], packing->box, packing->slots[k].radius);
+}
+
+static void
+packing_add_search_stats(Packing_t *packing, const PSO_result_t *result)
+{
+    /* Function to add the statistics of the PSO search */
+    packing->iterations_num += result->iterations;
+    packing->evaluations_num += result->evaluations_num;
+    packing->infeasible_num += result->infeasible_num;
+    packing->cache_hits += result->cache_hits;
+    packing->cache_misses += result->cache_misses;
+    packing->pruned_num += result->pruned_num;
+}
+
+static void
+packing_log_placement(Packing_t *packing, const Circle_t *circle, const u32 iterations)
+{
+    /* Function to push the event of the placed circle into the placement log. The cost is
+       calculated for the final position (the sub-pixel center is settled after the search) */
+    Placement_event_t event;
+
+    if (NULL == packing->placement_log) {
+        return;
+    }
+    event.index = packing->box->packed_circles_num - 1;
+    event.position = circle->position;
+    event.radius = circle->radius;
+    event.color = circle->color;
+    event.iterations = iterations;
+    event.cost = box_position_cost(packing->box, circle->position);
+    placement_log_push(packing->placement_log, &event);
+}
@@ -0,0 +1,283 @@
+/*================================================================================*/
+/* Realization of placement_log methods                                           */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <sched.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+/* Program includes: */
+#include <placement_log.h>
+#include <utils.h>
+#include <misc.h>
+
+/* Largest size of one encoded event (the buffer is written before it has less free space) */
+#define PLACEMENT_LOG_EVENT_MAX 256
+
+/* Time (in ms) the writer sleeps on the empty ring if it is not woken up before */
+#define PLACEMENT_LOG_WAIT_MS 5
+
+/* Static functions */
+/* Thread function of the writer: encodes the events of the ring and writes them to the file */
+static void* placement_log_writer(void *data);
+/* Function to wake up the writer thread */
+static void placement_log_wake(Placement_log_t *log);
+/* Function to wait for the wake up of the writer thread (or for the timeout) */
+static void placement_log_wait(Placement_log_t *log);
+/* Function to encode the event into the output buffer */
+static void placement_log_encode(Placement_log_t *log, const Placement_event_t *event);
+/* Function to append the u32 number to the output buffer (little-endian) */
+static void placement_log_put_u32(Placement_log_t *log, const u32 value);
+/* Function to format the coordinate (in the geometry units) in pix */
+static void placement_log_format_coordinate(const Placement_log_t *log, const u32 value, char *text,
+                                            const size_t text_size);
+/* Function to write the output buffer to the file */
+static void placement_log_flush(Placement_log_t *log);
+
+Placement_log_t*
+placement_log_create(const char *file_path, const Placement_log_format_t format, const u32 subpixel_bits)
+{
+    /* Method for creation of the placement log (malloc). The file is not buffered by the stdio,
+       the writer thread writes the whole output buffer at once. The header of the format is put
+       into the buffer before the writer is started */
+    Placement_log_t *tmp_log;
+    FILE *file;
+
+    file = fopen(file_path, (format == PLACEMENT_LOG_BINARY) ? "wb" : "w");
+    if (NULL == file) {
+        return NULL;
+    }
+    setvbuf(file, NULL, _IONBF, 0);
+
+    tmp_log = (Placement_log_t *) calloc (1, sizeof(Placement_log_t));
+    if (NULL == tmp_log) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_log->events = (Placement_event_t *) calloc (PLACEMENT_LOG_RING_SIZE, sizeof(Placement_event_t));
+    if (NULL == tmp_log->events) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_log->buffer = (u8 *) calloc (PLACEMENT_LOG_BUFFER_SIZE, sizeof(u8));
+    if (NULL == tmp_log->buffer) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_log->file = file;
+    tmp_log->format = format;
+    tmp_log->subpixel_bits = subpixel_bits;
+    atomic_init(&tmp_log->head, 0);
+    atomic_init(&tmp_log->tail, 0);
+    atomic_init(&tmp_log->is_stopping, 0);
+    pthread_mutex_init(&tmp_log->mutex, NULL);
+    pthread_cond_init(&tmp_log->wake_cond, NULL);
+
+    switch (format) {
+    case PLACEMENT_LOG_BINARY:
+        placement_log_put_u32(tmp_log, PLACEMENT_LOG_MAGIC);
+        placement_log_put_u32(tmp_log, PLACEMENT_LOG_VERSION);
+        placement_log_put_u32(tmp_log, subpixel_bits);
+        break;
+    case PLACEMENT_LOG_CSV:
+        tmp_log->buffer_size = (size_t)sprintf((char *)tmp_log->buffer, "index,x,y,radius,color,iterations,cost\n");
+        break;
+    default:
+        break;
+    }
+
+    if (pthread_create(&tmp_log->thread, NULL, placement_log_writer, tmp_log) != 0) {
+        print_error_and_exit("Error in creation of the placement log thread!\n");
+    }
+
+    return tmp_log;
+}
+
+b32
+placement_log_delete(Placement_log_t *log)
+{
+    /* Method for deleting the placement log. The writer thread writes the rest of the events and
+       exits, then the file is closed */
+    b32 is_written;
+
+    atomic_store_explicit(&log->is_stopping, 1, memory_order_release);
+    placement_log_wake(log);
+    pthread_join(log->thread, NULL);
+
+    is_written = !log->is_failed && (fclose(log->file) == 0);
+
+    pthread_mutex_destroy(&log->mutex);
+    pthread_cond_destroy(&log->wake_cond);
+    free(log->buffer);
+    free(log->events);
+    free(log);
+    return is_written;
+}
+
+void
+placement_log_push(Placement_log_t *log, const Placement_event_t *event)
+{
+    /* Method to push the event into the ring (single producer). The event is copied into the free
+       element and published by the release store of the head, so the placement thread does not
+       take any lock. The writer is woken up when the ring becomes half full, if the ring is full
+       (the disk is slower than the placement) the event waits for the free element */
+    u64 head, used;
+
+    head = atomic_load_explicit(&log->head, memory_order_relaxed);
+    used = head - atomic_load_explicit(&log->tail, memory_order_acquire);
+    while (used == PLACEMENT_LOG_RING_SIZE) {
+        placement_log_wake(log);
+        sched_yield();
+        used = head - atomic_load_explicit(&log->tail, memory_order_acquire);
+    }
+
+    log->events[head & (PLACEMENT_LOG_RING_SIZE - 1)] = *event;
+    atomic_store_explicit(&log->head, head + 1, memory_order_release);
+
+    if (used + 1 == PLACEMENT_LOG_RING_SIZE / 2) {
+        placement_log_wake(log);
+    }
+}
+
+static void*
+placement_log_writer(void *data)
+{
+    /* Thread function of the writer. The published events are encoded into the output buffer and
+       released by the store of the tail, the buffer is written when it is full. On the empty ring
+       the writer sleeps till the wake up or the timeout. After the stop the rest of the events is
+       written */
+    Placement_log_t *log = (Placement_log_t *)data;
+    u64 head, tail;
+    int is_stopping;
+
+    tail = atomic_load_explicit(&log->tail, memory_order_relaxed);
+    for (;;) {
+        is_stopping = atomic_load_explicit(&log->is_stopping, memory_order_acquire);
+        head = atomic_load_explicit(&log->head, memory_order_acquire);
+        if (head == tail) {
+            if (is_stopping) {
+                break;
+            }
+            placement_log_wait(log);
+            continue;
+        }
+
+        while (tail != head) {
+            placement_log_encode(log, &log->events[tail & (PLACEMENT_LOG_RING_SIZE - 1)]);
+            tail += 1;
+            /* Elements are released by parts, so the waiting placement thread continues earlier */
+            if ((tail & 1023) == 0) {
+                atomic_store_explicit(&log->tail, tail, memory_order_release);
+            }
+        }
+        atomic_store_explicit(&log->tail, tail, memory_order_release);
+    }
+
+    placement_log_flush(log);
+    return NULL;
+}
+
+static void
+placement_log_wake(Placement_log_t *log)
+{
+    /* Function to wake up the writer thread */
+    pthread_mutex_lock(&log->mutex);
+    pthread_cond_signal(&log->wake_cond);
+    pthread_mutex_unlock(&log->mutex);
+}
+
+static void
+placement_log_wait(Placement_log_t *log)
+{
+    /* Function to wait for the wake up of the writer thread. The wake up between the check of the
+       ring and the wait is not lost for longer than the timeout */
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += PLACEMENT_LOG_WAIT_MS * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec += 1;
+        ts.tv_nsec -= 1000000000L;
+    }
+    pthread_mutex_lock(&log->mutex);
+    pthread_cond_timedwait(&log->wake_cond, &log->mutex, &ts);
+    pthread_mutex_unlock(&log->mutex);
+}
+
+static void
+placement_log_encode(Placement_log_t *log, const Placement_event_t *event)
+{
+    /* Function to encode the event into the output buffer (the buffer is written first if it may
+       have not enough free space) */
+    char x[32], y[32];
+    char *text;
+    u32 cost_bits;
+    int length;
+
+    if (log->buffer_size + PLACEMENT_LOG_EVENT_MAX > PLACEMENT_LOG_BUFFER_SIZE) {
+        placement_log_flush(log);
+    }
+
+    if (log->format == PLACEMENT_LOG_BINARY) {
+        memcpy(&cost_bits, &event->cost, sizeof(u32));
+        placement_log_put_u32(log, event->index);
+        placement_log_put_u32(log, event->position.x);
+        placement_log_put_u32(log, event->position.y);
+        placement_log_put_u32(log, event->radius);
+        placement_log_put_u32(log, event->color);
+        placement_log_put_u32(log, event->iterations);
+        placement_log_put_u32(log, cost_bits);
+        return;
+    }
+
+    placement_log_format_coordinate(log, event->position.x, x, sizeof(x));
+    placement_log_format_coordinate(log, event->position.y, y, sizeof(y));
+    text = (char *)log->buffer + log->buffer_size;
+    if (log->format == PLACEMENT_LOG_CSV) {
+        length = snprintf(text, PLACEMENT_LOG_EVENT_MAX, "%u,%s,%s,%u,#%06x,%u,%.9g\n", event->index, x, y,
+                          event->radius, event->color, event->iterations, (f64)event->cost);
+    }
+    else {
+        length = snprintf(text, PLACEMENT_LOG_EVENT_MAX,
+                          "{\"index\":%u,\"x\":%s,\"y\":%s,\"radius\":%u,\"color\":\"#%06x\",\"iterations\":%u,"
+                          "\"cost\":%.9g}\n", event->index, x, y, event->radius, event->color, event->iterations,
+                          (f64)event->cost);
+    }
+    if ((length > 0) && (length < PLACEMENT_LOG_EVENT_MAX)) {
+        log->buffer_size += (size_t)length;
+    }
+}
+
+static void
+placement_log_put_u32(Placement_log_t *log, const u32 value)
+{
+    /* Function to append the u32 number to the output buffer (little-endian) */
+    u32 i;
+
+    for (i = 0; i < 4; ++i) {
+        log->buffer[log->buffer_size + i] = (u8)(value >> (8 * i));
+    }
+    log->buffer_size += 4;
+}
+
+static void
+placement_log_format_coordinate(const Placement_log_t *log, const u32 value, char *text, const size_t text_size)
+{
+    /* Function to format the coordinate (in the geometry units) in pix. The unit 1/2^bits pix has
+       exactly bits decimal digits, so the value is printed exactly */
+    if (0 == log->subpixel_bits) {
+        snprintf(text, text_size, "%u", value);
+    }
+    else {
+        snprintf(text, text_size, "%.*f", (int)log->subpixel_bits, (f64)value / (f64)(1u << log->subpixel_bits));
+    }
+}
+
+static void
+placement_log_flush(Placement_log_t *log)
+{
+    /* Function to write the output buffer to the file (the failure is kept till the log deletion) */
+    if ((log->buffer_size > 0) && (fwrite(log->buffer, 1, log->buffer_size, log->file) != log->buffer_size)) {
+        log->is_failed = true;
+    }
+    log->buffer_size = 0;
+}
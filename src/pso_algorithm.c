@@ -7,23 +7,284 @@
 #include <stdlib.h>
 #include <math.h>
 #include <assert.h>
+#include <pthread.h>
 
 /* Program includes: */
 #include <pso_algorithm.h>
 #include <utils.h>
 #include <circle.h>
-#include <circles_list.h>
 #include <box.h>
 #include <misc.h>
+#include <thread_pool.h>
+#include <rng.h>
 
-/* Defined large constant */
-static const f32 large_f32 = 5000.0f;
+/* x86 SIMD kernels are compiled with the target attributes and selected at runtime */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define PSO_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+/* Width of the widest SIMD register in f32 elements (AVX). Lanes are padded to it */
+#define PSO_SIMD_WIDTH 8
+
+/* Number of particles in one task of the parallel costs evaluation */
+#define PSO_EVAL_CHUNK 16
+
+/* Number of entries of the costs cache of every swarm (power of 2) and the maximum number of the
+   stored entries (the cache is not filled above 3/4 to keep the probing short) */
+#define PSO_CACHE_SIZE 4096
+#define PSO_CACHE_MAX_USED (PSO_CACHE_SIZE / 4 * 3)
+
+/* Cost of the particle with the interception (never reached by the feasible positions) */
+static const f32 large_f32 = BOX_INFEASIBLE_COST;
+
+/* Context of the parallel costs evaluation job */
+struct PSO_eval_job {
+    PSO_t *pso;
+    PSO_swarm_t *swarm;
+    const Box_t *box;
+    u32 radius;
+};
+typedef struct PSO_eval_job PSO_eval_job_t;
+
+/* Context of the parallel islands job */
+struct PSO_island_job {
+    PSO_t *pso;
+    const Box_t *box;
+    u32 radius;
+    u32 iterations; /* Number of iterations to run (0 - initialization of the swarms) */
+};
+typedef struct PSO_island_job PSO_island_job_t;
+
+/* Types of the swarm update kernels */
+typedef void (*PSO_update_lane_fn_t)(const u32 n, f32 *pos, f32 *vel, const f32 *best, const f32 gbest,
+                                     const f32 *r1, const f32 *r2, const f32 w, const f32 c1, const f32 c2);
+typedef void (*PSO_update_bests_lane_fn_t)(const u32 n, f32 *pos, f32 *vel, f32 *best, const f32 *costs,
+                                           const f32 *best_costs);
+
+/* Static functions */
+static void pso_run_islands(PSO_t *pso, const Box_t *box, const u32 radius, const u32 iterations);
+static void pso_island_task(void *task_ctx, u32 task_index);
+static void pso_migrate(PSO_t *pso);
+static void pso_swarm_init(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius);
+static void pso_swarm_iterate(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                              const u32 iterations);
+static f32 pso_rnd_position(PSO_t *pso, PSO_swarm_t *swarm);
+static void pso_random_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                                f32 *position);
+static void pso_warm_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                              f32 *position);
+static void pso_surface_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                                 f32 *position);
+static void pso_add_warm_point(PSO_t *pso, const V2_u32_t point);
+static void pso_collect_warm_points(PSO_t *pso, const Box_t *box, const u32 radius,
+                                    const PSO_result_t *result);
+static void pso_evaluate_swarm(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius);
+static void pso_evaluate_range(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                               const u32 first, const u32 last);
+static void pso_evaluate_task(void *task_ctx, u32 task_index);
+static void pso_prune(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius);
+static void pso_cache_lookup(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius);
+static void pso_cache_store(PSO_t *pso, PSO_swarm_t *swarm);
+static u32 pso_cache_hash(const u32 x, const u32 y);
+static void pso_update_bests(PSO_t *pso, PSO_swarm_t *swarm);
+static b32 pso_swarm_is_converged(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius);
+static void pso_select_kernels(void);
+static void pso_select_kernels_once(void);
+static void pso_update_lane_scalar(const u32 n, f32 *pos, f32 *vel, const f32 *best, const f32 gbest,
+                                   const f32 *r1, const f32 *r2, const f32 w, const f32 c1, const f32 c2);
+static void pso_update_bests_lane_scalar(const u32 n, f32 *pos, f32 *vel, f32 *best, const f32 *costs,
+                                         const f32 *best_costs);
+
+/* Currently selected swarm update kernels (written only once, by pso_select_kernels_once) */
+static PSO_update_lane_fn_t pso_update_lane = pso_update_lane_scalar;
+static PSO_update_bests_lane_fn_t pso_update_bests_lane = pso_update_bests_lane_scalar;
+static pthread_once_t pso_kernels_once = PTHREAD_ONCE_INIT;
+
+static void
+pso_update_lane_scalar(const u32 n, f32 *pos, f32 *vel, const f32 *best, const f32 gbest,
+                       const f32 *r1, const f32 *r2, const f32 w, const f32 c1, const f32 c2)
+{
+    /* Kernel to update the velocities and positions of one lane (one variable of all particles).
+       Position outside the range 0.0 - 1.0 is reset to the particle best position */
+
+    u32 i;
+    f32 v, p;
+
+    for (i = 0; i < n; ++i) {
+        v = w * vel[i] + r1[i] * c1 * (best[i] - pos[i]) + r2[i] * c2 * (gbest - pos[i]);
+        p = pos[i] + v;
+        if ((p > 1.0f) || (p < 0.0f)) {
+            p = best[i];
+            v = 0.0f;
+        }
+        pos[i] = p;
+        vel[i] = v;
+    }
+}
+
+static void
+pso_update_bests_lane_scalar(const u32 n, f32 *pos, f32 *vel, f32 *best, const f32 *costs,
+                             const f32 *best_costs)
+{
+    /* Kernel to update the best positions of one lane after the costs evaluation. Particle with the
+       interception (cost is large_f32) is moved back to its best position */
+
+    u32 i;
+
+    for (i = 0; i < n; ++i) {
+        if (costs[i] >= large_f32) {
+            pos[i] = best[i];
+            vel[i] = 0.0f;
+        }
+        else if (costs[i] < best_costs[i]) {
+            best[i] = pos[i];
+        }
+    }
+}
+
+#ifdef PSO_X86_KERNELS
+__attribute__((target("sse2"))) static void
+pso_update_lane_sse(const u32 n, f32 *pos, f32 *vel, const f32 *best, const f32 gbest,
+                    const f32 *r1, const f32 *r2, const f32 w, const f32 c1, const f32 c2)
+{
+    /* SSE version of the lane update kernel (4 particles per instruction, n is multiple of 4) */
+
+    u32 i;
+    __m128 v, p, b, mask;
+    const __m128 vw = _mm_set1_ps(w);
+    const __m128 vc1 = _mm_set1_ps(c1);
+    const __m128 vc2 = _mm_set1_ps(c2);
+    const __m128 vg = _mm_set1_ps(gbest);
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (i = 0; i < n; i += 4) {
+        p = _mm_load_ps(pos + i);
+        b = _mm_load_ps(best + i);
+        v = _mm_mul_ps(vw, _mm_load_ps(vel + i));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_mul_ps(_mm_load_ps(r1 + i), vc1), _mm_sub_ps(b, p)));
+        v = _mm_add_ps(v, _mm_mul_ps(_mm_mul_ps(_mm_load_ps(r2 + i), vc2), _mm_sub_ps(vg, p)));
+        p = _mm_add_ps(p, v);
+        mask = _mm_or_ps(_mm_cmpgt_ps(p, one), _mm_cmplt_ps(p, zero));
+        p = _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, p));
+        v = _mm_andnot_ps(mask, v);
+        _mm_store_ps(pos + i, p);
+        _mm_store_ps(vel + i, v);
+    }
+}
+
+__attribute__((target("sse2"))) static void
+pso_update_bests_lane_sse(const u32 n, f32 *pos, f32 *vel, f32 *best, const f32 *costs,
+                          const f32 *best_costs)
+{
+    /* SSE version of the best positions update kernel (n is multiple of 4) */
+
+    u32 i;
+    __m128 p, b, c, inter, improved;
+    const __m128 large = _mm_set1_ps(large_f32);
+
+    for (i = 0; i < n; i += 4) {
+        p = _mm_load_ps(pos + i);
+        b = _mm_load_ps(best + i);
+        c = _mm_load_ps(costs + i);
+        inter = _mm_cmpge_ps(c, large);
+        improved = _mm_cmplt_ps(c, _mm_load_ps(best_costs + i));
+        _mm_store_ps(best + i, _mm_or_ps(_mm_and_ps(improved, p), _mm_andnot_ps(improved, b)));
+        _mm_store_ps(pos + i, _mm_or_ps(_mm_and_ps(inter, b), _mm_andnot_ps(inter, p)));
+        _mm_store_ps(vel + i, _mm_andnot_ps(inter, _mm_load_ps(vel + i)));
+    }
+}
+
+__attribute__((target("avx"))) static void
+pso_update_lane_avx(const u32 n, f32 *pos, f32 *vel, const f32 *best, const f32 gbest,
+                    const f32 *r1, const f32 *r2, const f32 w, const f32 c1, const f32 c2)
+{
+    /* AVX version of the lane update kernel (8 particles per instruction, n is multiple of 8) */
+
+    u32 i;
+    __m256 v, p, b, mask;
+    const __m256 vw = _mm256_set1_ps(w);
+    const __m256 vc1 = _mm256_set1_ps(c1);
+    const __m256 vc2 = _mm256_set1_ps(c2);
+    const __m256 vg = _mm256_set1_ps(gbest);
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (i = 0; i < n; i += 8) {
+        p = _mm256_load_ps(pos + i);
+        b = _mm256_load_ps(best + i);
+        v = _mm256_mul_ps(vw, _mm256_load_ps(vel + i));
+        v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_mul_ps(_mm256_load_ps(r1 + i), vc1), _mm256_sub_ps(b, p)));
+        v = _mm256_add_ps(v, _mm256_mul_ps(_mm256_mul_ps(_mm256_load_ps(r2 + i), vc2), _mm256_sub_ps(vg, p)));
+        p = _mm256_add_ps(p, v);
+        mask = _mm256_or_ps(_mm256_cmp_ps(p, one, _CMP_GT_OQ), _mm256_cmp_ps(p, zero, _CMP_LT_OQ));
+        _mm256_store_ps(pos + i, _mm256_blendv_ps(p, b, mask));
+        _mm256_store_ps(vel + i, _mm256_andnot_ps(mask, v));
+    }
+}
+
+__attribute__((target("avx"))) static void
+pso_update_bests_lane_avx(const u32 n, f32 *pos, f32 *vel, f32 *best, const f32 *costs,
+                          const f32 *best_costs)
+{
+    /* AVX version of the best positions update kernel (n is multiple of 8) */
+
+    u32 i;
+    __m256 p, b, c, inter, improved;
+    const __m256 large = _mm256_set1_ps(large_f32);
+
+    for (i = 0; i < n; i += 8) {
+        p = _mm256_load_ps(pos + i);
+        b = _mm256_load_ps(best + i);
+        c = _mm256_load_ps(costs + i);
+        inter = _mm256_cmp_ps(c, large, _CMP_GE_OQ);
+        improved = _mm256_cmp_ps(c, _mm256_load_ps(best_costs + i), _CMP_LT_OQ);
+        _mm256_store_ps(best + i, _mm256_blendv_ps(b, p, improved));
+        _mm256_store_ps(pos + i, _mm256_blendv_ps(p, b, inter));
+        _mm256_store_ps(vel + i, _mm256_andnot_ps(inter, _mm256_load_ps(vel + i)));
+    }
+}
+#endif /* PSO_X86_KERNELS */
+
+static void
+pso_select_kernels(void)
+{
+    /* Function to select the kernels before the first use. The PSO objects are created by several
+       threads (ensemble runs), so the selection is done only once for all of them */
+    pthread_once(&pso_kernels_once, pso_select_kernels_once);
+}
+
+static void
+pso_select_kernels_once(void)
+{
+    /* Function to select the fastest swarm update kernels supported by the CPU */
+#ifdef PSO_X86_KERNELS
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx")) {
+        pso_update_lane = pso_update_lane_avx;
+        pso_update_bests_lane = pso_update_bests_lane_avx;
+    }
+    else if (__builtin_cpu_supports("sse2")) {
+        pso_update_lane = pso_update_lane_sse;
+        pso_update_bests_lane = pso_update_bests_lane_sse;
+    }
+#endif
+}
 
 PSO_t*
-pso_create(const u32 n_var, const u32 n_pop)
+pso_create(const u32 n_var, const u32 n_pop, const u32 n_islands)
 {
-    /* Method for creation of the pso algorithm object (malloc) */
+    /* Method for creation of the pso algorithm object with n_islands independent swarms of n_pop
+       particles (malloc) */
     PSO_t *tmp_pso;
+    PSO_swarm_t *swarm;
+    u32 n_pop_pad;
+    u32 i, k;
+
+    /* Swarm is stored as x and y lanes, so only 2 search variables are supported */
+    assert(n_var == 2);
+    assert(n_islands > 0);
       
     /* Allocate the memory for the pso algorithm object */
     tmp_pso = (PSO_t *) calloc (1, sizeof(PSO_t));
@@ -31,15 +292,57 @@ pso_create(const u32 n_var, const u32 n_pop)
     
     tmp_pso->n_var = n_var; /* Number of unknown (decision) variables */ 
     tmp_pso->n_pop = n_pop; /* Population size (swarm size) */
+    tmp_pso->n_islands = n_islands; /* Number of independent swarms */
+
+    /* Every lane is padded up to the width of AVX register (8 floats) */
+    n_pop_pad = ((n_pop + PSO_SIMD_WIDTH - 1) / PSO_SIMD_WIDTH) * PSO_SIMD_WIDTH;
+    tmp_pso->n_pop_pad = n_pop_pad;
+
+    tmp_pso->swarms = (PSO_swarm_t *) calloc (n_islands, sizeof(PSO_swarm_t));
+    if (NULL == tmp_pso->swarms) print_error_and_exit("Error in memory allocation!\n");
     
-    /* Allocation memory for the additional fields */
-    tmp_pso->part_positions = dynamic_2d_f32_array_alloc(n_pop, n_var);
-    tmp_pso->tmp_position = dynamic_1d_f32_array_alloc(n_var);
-    tmp_pso->part_best_positions = dynamic_2d_f32_array_alloc(n_pop, n_var);
-    tmp_pso->part_velocities = dynamic_2d_f32_array_alloc(n_pop, n_var);
-    tmp_pso->part_costs = dynamic_1d_f32_array_alloc(n_pop);
-    tmp_pso->part_best_costs = dynamic_1d_f32_array_alloc(n_pop);
-    tmp_pso->global_best_position = dynamic_1d_f32_array_alloc(n_var);
+    /* Allocation memory for the fields of every swarm (contiguous and aligned lanes) */
+    for (k = 0; k < n_islands; ++k) {
+        swarm = &tmp_pso->swarms[k];
+        swarm->part_positions = dynamic_1d_f32_aligned_alloc(n_pop_pad * n_var);
+        swarm->part_best_positions = dynamic_1d_f32_aligned_alloc(n_pop_pad * n_var);
+        swarm->part_velocities = dynamic_1d_f32_aligned_alloc(n_pop_pad * n_var);
+        swarm->part_costs = dynamic_1d_f32_aligned_alloc(n_pop_pad);
+        swarm->part_feasible = (b32 *) calloc (n_pop_pad, sizeof(b32));
+        if (NULL == swarm->part_feasible) print_error_and_exit("Error in memory allocation!\n");
+        swarm->part_best_costs = dynamic_1d_f32_aligned_alloc(n_pop_pad);
+        swarm->global_best_position = dynamic_1d_f32_array_alloc(n_var);
+        swarm->r1 = dynamic_1d_f32_aligned_alloc(n_pop_pad * n_var);
+        swarm->r2 = dynamic_1d_f32_aligned_alloc(n_pop_pad * n_var);
+        swarm->part_pixels = (u32 *) calloc (n_pop_pad * n_var, sizeof(u32));
+        swarm->eval_indices = (u32 *) calloc (n_pop_pad, sizeof(u32));
+        swarm->eval_pixels = (u32 *) calloc (n_pop_pad * n_var, sizeof(u32));
+        swarm->eval_costs = dynamic_1d_f32_aligned_alloc(n_pop_pad);
+        swarm->eval_feasible = (b32 *) calloc (n_pop_pad, sizeof(b32));
+        swarm->cache = (PSO_cache_entry_t *) calloc (PSO_CACHE_SIZE, sizeof(PSO_cache_entry_t));
+        if ((NULL == swarm->part_pixels) || (NULL == swarm->eval_indices) || (NULL == swarm->eval_pixels) ||
+            (NULL == swarm->eval_feasible) || (NULL == swarm->cache)) {
+            print_error_and_exit("Error in memory allocation!\n");
+        }
+        swarm->cache_generation = 0; /* All entries of the calloc-ed cache are empty */
+
+        /* Random numbers of the padding particles are never updated */
+        for (i = 0; i < n_pop_pad * n_var; ++i) {
+            swarm->r1[i] = 0.0f;
+            swarm->r2[i] = 0.0f;
+        }
+        rng_seed(&swarm->rng, 0, k);
+    }
+
+    /* Ring of the warm start points (free positions of one swarm and the placement) */
+    tmp_pso->warm_points_capacity = 2 * n_pop + 1;
+    tmp_pso->warm_points = (V2_u32_t *) calloc (tmp_pso->warm_points_capacity, sizeof(V2_u32_t));
+    if (NULL == tmp_pso->warm_points) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_pso->use_cache = true;
+
+    /* Select the swarm update kernels for the current CPU */
+    pso_select_kernels();
     
     return tmp_pso;
 }
@@ -48,21 +351,37 @@ void
 pso_delete(PSO_t *pso)
 {
     /* Method for deleting the pso algorithm object */
-    /* Delete dynamically allocated fields of the pso object */
-    dynamic_2d_f32_array_free(pso->part_positions, pso->n_pop);
-    free(pso->tmp_position);
-    dynamic_2d_f32_array_free(pso->part_best_positions, pso->n_pop);
-    dynamic_2d_f32_array_free(pso->part_velocities, pso->n_pop);
-    free(pso->part_costs);
-    free(pso->part_best_costs);
-    free(pso->global_best_position);
+    PSO_swarm_t *swarm;
+    u32 k;
+
+    /* Delete dynamically allocated fields of the every swarm */
+    for (k = 0; k < pso->n_islands; ++k) {
+        swarm = &pso->swarms[k];
+        dynamic_1d_f32_aligned_free(swarm->part_positions);
+        dynamic_1d_f32_aligned_free(swarm->part_best_positions);
+        dynamic_1d_f32_aligned_free(swarm->part_velocities);
+        dynamic_1d_f32_aligned_free(swarm->part_costs);
+        free(swarm->part_feasible);
+        dynamic_1d_f32_aligned_free(swarm->part_best_costs);
+        free(swarm->global_best_position);
+        dynamic_1d_f32_aligned_free(swarm->r1);
+        dynamic_1d_f32_aligned_free(swarm->r2);
+        free(swarm->part_pixels);
+        free(swarm->eval_indices);
+        free(swarm->eval_pixels);
+        dynamic_1d_f32_aligned_free(swarm->eval_costs);
+        free(swarm->eval_feasible);
+        free(swarm->cache);
+    }
+    free(pso->swarms);
+    free(pso->warm_points);
 
     free(pso);    
 }
 
 void pso_init(PSO_t *pso, const f32 var_min, const f32 var_max, const b32 use_iter_limit,
               const u32 iter_limit, const f32 w_init, const f32 w_damp, const f32 c1, const f32 c2,
-              const u32 a, const u32 b)
+              const u32 a, const u32 b, const u32 migration_interval)
 {
     /* Initialization of the PSO algorithm */
 
@@ -77,270 +396,843 @@ void pso_init(PSO_t *pso, const f32 var_min, const f32 var_max, const b32 use_it
     pso->c2 = c2; /* Social acceleration coefficient */
     pso->a = a; /* Additional randomization of a-th particle in swarm */
     pso->b = b; /* Additional randomization of all particles every b-th iteration */
+    pso->migration_interval = migration_interval; /* Iterations between the islands migrations */
+
+    /* Forget the warm start points of the previous packing */
+    pso->warm_points_num = 0;
+    pso->warm_points_next = 0;
+}
+
+void
+pso_seed(PSO_t *pso, const u64 seed, const u64 first_stream)
+{
+    /* Method to seed the random numbers generators of all swarms. Every island gets its own stream
+       of the seed (first_stream + k), so the search is reproducible with any number of threads */
+    u32 k;
+
+    for (k = 0; k < pso->n_islands; ++k) {
+        rng_seed(&pso->swarms[k].rng, seed, first_stream + k);
+    }
+}
+
+void
+pso_set_thread_pool(PSO_t *pso, Thread_pool_t *thread_pool)
+{
+    /* Method to set the thread pool for the parallel work. The pool is owned by the caller. With
+       several islands every island is run by its own task, with one island the costs of particles
+       are evaluated in parallel. NULL - everything is done serially in the calling thread */
+    pso->thread_pool = thread_pool;
+}
+
+void
+pso_set_early_termination(PSO_t *pso, const u32 stall_limit, const f32 spread_tol)
+{
+    /* Method to set the early termination criteria. The swarm stops after stall_limit iterations
+       without improvement of its global best cost, or when the best positions of all its particles
+       lie within spread_tol pixels. Both criteria are checked only after a feasible position has
+       been found, so the failed search still runs up to the iteration limit. 0 - criterion is off */
+    pso->stall_limit = stall_limit;
+    pso->spread_tol = spread_tol;
+}
+
+void
+pso_set_warm_start(PSO_t *pso, const f32 warm_fraction, const u32 warm_spread)
+{
+    /* Method to set the warm start of the search. After every successful search its placement and
+       the feasible best positions of the particles are kept as the warm start points. At the next
+       search the warm_fraction of the particles is seeded at random within warm_spread pixels from
+       a random warm start point, the rest of the swarm is random over the whole box. 0.0 - off */
+    pso->warm_fraction = warm_fraction;
+    pso->warm_spread = warm_spread;
+}
+
+void
+pso_set_cost_cache(PSO_t *pso, const b32 use_cache)
+{
+    /* Method to enable or disable the cache of the costs evaluations. Particles are evaluated on
+       the pixels lattice, so the cost of the already visited pixel is taken from the cache of the
+       swarm (valid for one search) instead of the new collision check */
+    pso->use_cache = use_cache;
+}
+
+void
+pso_set_surface_start(PSO_t *pso, const f32 surface_fraction, const u32 surface_spread)
+{
+    /* Method to set the surface start of the search. The best places are at the fill surface, so
+       the surface_fraction of the particles (not warm started) is seeded at a random column within
+       surface_spread pixels above the skyline of the box, where the circle surely fits. 0.0 - off */
+    pso->surface_fraction = surface_fraction;
+    pso->surface_spread = surface_spread;
+}
+
+void
+pso_set_pruning(PSO_t *pso, const b32 use_pruning)
+{
+    /* Method to enable or disable the pruning of the candidates. The cost of the candidate is known
+       before the collision check, so the candidate not better than the best position of its
+       particle can't change the bests. Such candidate is accepted if it is above the skyline and
+       rejected (moved back as the interception) otherwise, without the collision check */
+    pso->use_pruning = use_pruning;
+}
+
+void
+pso_set_open_sampling(PSO_t *pso, const b32 use_open_sampling)
+{
+    /* Method to enable or disable the open sampling. The random positions of the particles (at the
+       initialization and the additional randomizations) are taken from the tiles of the box which
+       can still hold the smallest circle, instead of the whole box, so the particles do not land
+       in the packed regions. If the box has no open tiles the whole box is used */
+    pso->use_open_sampling = use_open_sampling;
 }
 
 PSO_result_t
 pso_run_search(PSO_t *pso, const Box_t *box, const u32 radius)
 {
     /* Method to start the search of circle coordinates and return the results. Here the radius is the
-       radius of the tested circle */
+       radius of the tested circle. Every island runs its own swarm, after every migration_interval
+       iterations the best position of all islands is migrated to the other islands. The search
+       is stopped by the iteration limit or when all the islands are converged. The result is the
+       best position of all islands */
 
-    u32 i, j;
     PSO_result_t result;
+    PSO_swarm_t *best_swarm;
+    u32 k;
+    u32 iteration; /* Number of the first iteration of the current epoch */
+    u32 iterations; /* Number of iterations of the current epoch */
     b32 do_search;
 
     /* ===== 1. INITIALIZATION OF THE PSO ALGORITHM ===== */
-    pso->iteration = 1;
-    pso->w = pso->w_init;
-    pso->is_solution_found = false;
+    pso_run_islands(pso, box, radius, 0);
+    iteration = 1;
     do_search = true;
     
-    /* Initialize the best costs with very high values */
-    pso->global_best_cost = large_f32;
-    for (i = 0; i < pso->n_pop; ++i) {
-        pso->part_best_costs[i] = large_f32;
+    /* ===== 2. SEARCHING LOOP OF THE PSO ALGORITHM (epochs between migrations) ===== */
+    while (do_search) {
+        /* Number of iterations till the next migration (0 - islands are never migrated) */
+        iterations = (pso->migration_interval > 0) ? pso->migration_interval : pso->iter_limit;
+        if (pso->use_iter_limit) {
+            if (iterations > pso->iter_limit + 1 - iteration) {
+                iterations = pso->iter_limit + 1 - iteration;
+            }
+        }
+        pso_run_islands(pso, box, radius, iterations);
+        iteration += iterations;
+
+        /* Check the search termination by iteration limit and by convergence of all islands */
+        do_search = !((pso->use_iter_limit) && (iteration > pso->iter_limit));
+        if (do_search) {
+            do_search = false;
+            for (k = 0; k < pso->n_islands; ++k) {
+                if (!pso->swarms[k].is_converged) do_search = true;
+            }
+        }
+        if (do_search) {
+            pso_migrate(pso);
+        }
     }
-    
-    /* Randomize the position of the particles */
-    for (i = 0; i < pso->n_pop; ++i) {
-        for (j = 0; j < pso->n_var; ++j) {
-            pso->part_positions[i][j] = pso->var_min + (pso->var_max - pso->var_min) * rnd_f32();
+
+    /* Prepare and return the result structure from the best island */
+    best_swarm = &pso->swarms[0];
+    for (k = 1; k < pso->n_islands; ++k) {
+        if (pso->swarms[k].global_best_cost < best_swarm->global_best_cost) {
+            best_swarm = &pso->swarms[k];
         }
     }
+    result.is_solution_found = (best_swarm->global_best_cost < large_f32);
+    result.global_best_coordinates = pso_calc_coordinates(box, radius, best_swarm->global_best_position);
+    result.iterations = 0;
+    result.evaluations_num = 0;
+    result.infeasible_num = 0;
+    result.cache_hits = 0;
+    result.cache_misses = 0;
+    result.pruned_num = 0;
+    for (k = 0; k < pso->n_islands; ++k) {
+        if (pso->swarms[k].iteration - 1 > result.iterations) {
+            result.iterations = pso->swarms[k].iteration - 1;
+        }
+        result.evaluations_num += pso->swarms[k].iteration * pso->n_pop;
+        result.infeasible_num += pso->swarms[k].infeasible_num;
+        result.cache_hits += pso->swarms[k].cache_hits;
+        result.cache_misses += pso->swarms[k].cache_misses;
+        result.pruned_num += pso->swarms[k].pruned_num;
+    }
 
-    /* Initialize the particle velocities with zeros */
-    for (i = 0; i < pso->n_pop; ++i) {
-        for (j = 0; j < pso->n_var; ++j) {
-            pso->part_velocities[i][j] = 0.0f;
+    /* Keep the found place and free positions for the warm start of the next search */
+    if ((pso->warm_fraction > 0.0f) && (result.is_solution_found)) {
+        pso_collect_warm_points(pso, box, radius, &result);
+    }
+
+    return result;
+}
+
+static void
+pso_run_islands(PSO_t *pso, const Box_t *box, const u32 radius, const u32 iterations)
+{
+    /* Function to run all the islands for the given number of iterations (0 - initialization of the
+       swarms). With the thread pool and several islands every island is run by its own task */
+
+    PSO_island_job_t job;
+    u32 k;
+
+    job.pso = pso;
+    job.box = box;
+    job.radius = radius;
+    job.iterations = iterations;
+
+    if ((NULL != pso->thread_pool) && (pso->n_islands > 1)) {
+        thread_pool_run(pso->thread_pool, pso_island_task, &job, pso->n_islands);
+    }
+    else {
+        for (k = 0; k < pso->n_islands; ++k) {
+            pso_island_task(&job, k);
         }
     }
-    
-    /* Update the costs for every particle in the population */
-    for (i = 0; i < pso->n_pop; ++i) {
-        
-        /* Copy the current particle position to time position */
-        for (j = 0; j < pso->n_var; ++j) {
-            pso->tmp_position[j] = pso->part_positions[i][j];
+}
+
+static void
+pso_island_task(void *task_ctx, u32 task_index)
+{
+    /* Task of the one island: initialization or several iterations of the swarm */
+
+    PSO_island_job_t *job = (PSO_island_job_t *)task_ctx;
+    PSO_swarm_t *swarm = &job->pso->swarms[task_index];
+
+    if (job->iterations == 0) {
+        pso_swarm_init(job->pso, swarm, job->box, job->radius);
+    }
+    else {
+        pso_swarm_iterate(job->pso, swarm, job->box, job->radius, job->iterations);
+    }
+}
+
+static void
+pso_migrate(PSO_t *pso)
+{
+    /* Function for the migration of the best position among all islands to the other islands. It
+       becomes the global best of the island (particles follow it by the social component) */
+
+    PSO_swarm_t *best_swarm;
+    u32 j, k;
+
+    best_swarm = &pso->swarms[0];
+    for (k = 1; k < pso->n_islands; ++k) {
+        if (pso->swarms[k].global_best_cost < best_swarm->global_best_cost) {
+            best_swarm = &pso->swarms[k];
         }
+    }
 
-        /* Update the current particle cost */
-        pso->part_costs[i] = pso_calculate_cost(pso, box, radius);
-        
-        /* Update the particle best cost and position so far */
-        if (pso->part_costs[i] < pso->part_best_costs[i]) {
-            pso->part_best_costs[i] = pso->part_costs[i];
+    for (k = 0; k < pso->n_islands; ++k) {
+        if (best_swarm->global_best_cost < pso->swarms[k].global_best_cost) {
+            pso->swarms[k].global_best_cost = best_swarm->global_best_cost;
             for (j = 0; j < pso->n_var; ++j) {
-                pso->part_best_positions[i][j] = pso->tmp_position[j];
+                pso->swarms[k].global_best_position[j] = best_swarm->global_best_position[j];
             }
         }
+    }
+}
 
-        /* Update the global cost and global best position */
-        if (pso->part_costs[i] < pso->global_best_cost) {
-            pso->global_best_cost = pso->part_costs[i];
-            for (j = 0; j < pso->n_var; ++j) {
-                pso->global_best_position[j] = pso->tmp_position[j];
-            }
+static void
+pso_swarm_init(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius)
+{
+    /* Function for the initialization of the swarm: random positions, zero velocities and the
+       initial costs and best positions */
+
+    u32 i, j;
+    u32 n_pad = pso->n_pop_pad; /* Length of the one lane (padded population) */
+    u32 n_warm; /* Number of particles seeded around the warm start points */
+    u32 n_surface; /* Number of particles seeded above the skyline */
+    f32 position[2];
+
+    swarm->iteration = 1;
+    swarm->w = pso->w_init;
+    swarm->is_solution_found = false;
+    swarm->stall_iterations = 0;
+    swarm->is_converged = false;
+    swarm->infeasible_num = 0;
+    swarm->cache_hits = 0;
+    swarm->cache_misses = 0;
+    swarm->pruned_num = 0;
+
+    /* New generation of the cache: all stored entries become empty */
+    swarm->cache_used = 0;
+    swarm->cache_generation += 1;
+    if (swarm->cache_generation == 0) {
+        for (i = 0; i < PSO_CACHE_SIZE; ++i) {
+            swarm->cache[i].generation = 0;
         }
+        swarm->cache_generation = 1;
     }
     
-    /* ===== 2. SEARCHING LOOP OF THE PSO ALGORITHM ===== */
-    while(do_search) {
-        for (i = 0; i < pso->n_pop; ++i) {
-            for (j = 0; j < pso->n_var; ++j) {
-                
-                /* Randomize r1 and r2 parameters (0 - 1)*/
-                pso->r1 = rnd_f32();
-                pso->r2 = rnd_f32();
-
-                /* Update the velocity */
-                pso->part_velocities[i][j] = pso->w * pso->part_velocities[i][j] + 
-                    pso->r1 * pso->c1 * (pso->part_best_positions[i][j] - pso->part_positions[i][j]) + 
-                    pso->r2 * pso->c2 * (pso->global_best_position[j] - pso->part_positions[i][j]);
-
-                /* Update the particle position */
-                pso->part_positions[i][j] += pso->part_velocities[i][j];
-
-                /* Making restrictions to the particles positions. Components of the position vector
-                   should be in range 0.0 - 1.0. Reset the particle position to their best position. */
-                if (pso->part_positions[i][j] > 1.0f) {
-                    //pso->part_positions[i][j] = pso->var_min + (pso->var_max - pso->var_min) * rnd_f32();
-                    pso->part_positions[i][j] = pso->part_best_positions[i][j];
-                    pso->part_velocities[i][j] = 0.0f;
-                }
-                if (pso->part_positions[i][j] < 0.0f) {
-                    //pso->part_positions[i][j] = pso->var_min + (pso->var_max - pso->var_min) * rnd_f32();
-                    pso->part_positions[i][j] = pso->part_best_positions[i][j];
-                    pso->part_velocities[i][j] = 0.0f;
-                }              
-            } /* for j */
-			
-            /* Additional randomization: every A-th particle should be randomized */
-            if ((i % pso->a) == 0) {
-                for (j = 0; j < pso->n_var; ++j) {
-                    pso->part_positions[i][j] = pso->var_min + (pso->var_max - pso->var_min) * rnd_f32();
-                }
-            }
-            
-            /* Additional randomization: reset of particles every B-th iteration */
-            if ((pso->iteration % pso->b) == 0) {
-                for (j = 0; j < pso->n_var; ++j) {
-                    pso->part_positions[i][j] = pso->var_min + (pso->var_max - pso->var_min) * rnd_f32();
-                }
-            }
+    /* Initialize the best costs with very high values (also for the padding particles) */
+    swarm->global_best_cost = large_f32;
+    for (i = 0; i < n_pad; ++i) {
+        swarm->part_best_costs[i] = large_f32;
+        swarm->part_costs[i] = large_f32;
+    }
+    
+    /* Number of warm started particles (the last ones, they are not randomized every iteration) */
+    n_warm = 0;
+    if (pso->warm_points_num > 0) {
+        n_warm = (u32)(pso->warm_fraction * (f32)pso->n_pop);
+        if (n_warm > pso->n_pop) n_warm = pso->n_pop;
+    }
 
-            /* Copy the current particle position to time position */
-            for (j = 0; j < pso->n_var; ++j) {
-                pso->tmp_position[j] = pso->part_positions[i][j];
-            }
+    /* Number of surface started particles (just before the warm started ones) */
+    n_surface = (u32)(pso->surface_fraction * (f32)pso->n_pop);
+    if (n_surface > pso->n_pop - n_warm) n_surface = pso->n_pop - n_warm;
+
+    /* Randomize the position of the particles, reset the velocities and the best positions */
+    for (i = 0; i < n_pad; ++i) {
+        if (i >= pso->n_pop) {
+            position[0] = 0.0f;
+            position[1] = 0.0f;
+        }
+        else if (i >= pso->n_pop - n_warm) {
+            pso_warm_position(pso, swarm, box, radius, position);
+        }
+        else if (i >= pso->n_pop - n_warm - n_surface) {
+            pso_surface_position(pso, swarm, box, radius, position);
+        }
+        else {
+            pso_random_position(pso, swarm, box, radius, position);
+        }
+        for (j = 0; j < pso->n_var; ++j) {
+            swarm->part_positions[j * n_pad + i] = position[j];
+            swarm->part_best_positions[j * n_pad + i] = position[j];
+            swarm->part_velocities[j * n_pad + i] = 0.0f;
+        }
+    }
+    
+    /* Update the costs and the best positions for every particle in the population */
+    pso_evaluate_swarm(pso, swarm, box, radius);
+    pso_update_bests(pso, swarm);
+}
 
-            /* Update the current particle cost */
-            pso->part_costs[i] = pso_calculate_cost(pso, box, radius);
+static void
+pso_swarm_iterate(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius,
+                  const u32 iterations)
+{
+    /* Function to run several iterations of the swarm. Swarm is updated synchronously: all particles
+       are moved with the global best of the previous iteration, then all the costs are evaluated.
+       Converged swarm is not iterated anymore */
 
-            /* if there was in interception, then fuction return large_f32 -> change the position
-               of the particle */
-            if (pso->part_costs[i] >= large_f32) {
-                for (j = 0; j < pso->n_var; ++j) {
-                    pso->part_positions[i][j] = pso->part_best_positions[i][j];
-                    pso->part_velocities[i][j] = 0.0f;
-                }
-            }
+    u32 i, j, n;
+    u32 n_pad = pso->n_pop_pad; /* Length of the one lane (padded population) */
+    f32 prev_best_cost; /* Global best cost before the iteration */
+    f32 position[2];
+
+    for (n = 0; (n < iterations) && (!swarm->is_converged); ++n) {
+        
+        /* Randomize r1 and r2 parameters (0 - 1) for every particle and variable */
+        for (j = 0; j < pso->n_var; ++j) {
+            rng_fill_f32(&swarm->rng, swarm->r1 + j * n_pad, pso->n_pop);
+            rng_fill_f32(&swarm->rng, swarm->r2 + j * n_pad, pso->n_pop);
+        }
 
-            /* Update the particle best cost and position so far */
-            if (pso->part_costs[i] < pso->part_best_costs[i]) {
-                pso->part_best_costs[i] = pso->part_costs[i];
+        /* Update the velocities and positions of the whole swarm, lane by lane. Components of the
+           position vector should be in range 0.0 - 1.0, otherwise the particle position is reset to
+           its best position */
+        for (j = 0; j < pso->n_var; ++j) {
+            pso_update_lane(n_pad, swarm->part_positions + j * n_pad, swarm->part_velocities + j * n_pad,
+                            swarm->part_best_positions + j * n_pad, swarm->global_best_position[j],
+                            swarm->r1 + j * n_pad, swarm->r2 + j * n_pad, swarm->w, pso->c1, pso->c2);
+        }
+
+        for (i = 0; i < pso->n_pop; ++i) {
+            /* Additional randomization: every A-th particle should be randomized */
+            /* Additional randomization: reset of particles every B-th iteration */
+            if (((i % pso->a) == 0) || ((swarm->iteration % pso->b) == 0)) {
+                pso_random_position(pso, swarm, box, radius, position);
                 for (j = 0; j < pso->n_var; ++j) {
-                    pso->part_best_positions[i][j] = pso->tmp_position[j];
+                    swarm->part_positions[j * n_pad + i] = position[j];
                 }
             }
+        }
 
-            /* Update the global cost and global best position */
-            if (pso->part_costs[i] < pso->global_best_cost) {
-                pso->global_best_cost = pso->part_costs[i];
-                for (j = 0; j < pso->n_var; ++j) {
-                    pso->global_best_position[j] = pso->tmp_position[j];
-                }
-            }	
-        } /* for i */
+        /* Update the costs of particles and their best positions (if there was an interception,
+           the particle position is changed to its best position) */
+        prev_best_cost = swarm->global_best_cost;
+        pso_evaluate_swarm(pso, swarm, box, radius);
+        pso_update_bests(pso, swarm);
+
+        /* Count the iterations without improvement and check the early termination */
+        if (swarm->global_best_cost < prev_best_cost) {
+            swarm->stall_iterations = 0;
+        }
+        else {
+            swarm->stall_iterations += 1;
+        }
+        swarm->is_converged = pso_swarm_is_converged(pso, swarm, box, radius);
 		
         /* Reduce the inertia coefficient */
-        pso->w = pso->w * pso->w_damp;
+        swarm->w = swarm->w * pso->w_damp;
 
         /* Reset the inertia coefficient every B-th iteration  */
-        if ((pso->iteration % pso->b) == 0) {
-            pso->w = pso->w_init;
+        if ((swarm->iteration % pso->b) == 0) {
+            swarm->w = pso->w_init;
         }
 
-        /* Check the search termination by iteration limit */
-        if ((pso->use_iter_limit) && (pso->iteration >= pso->iter_limit)) {
-            do_search = false;
+        swarm->iteration += 1;
+    }
+}
 
-            /* Prepare and return the result structure */
-            result.is_solution_found = pso->is_solution_found;
-            result.global_best_coordinates = pso_calc_coordinates(pso, box, radius);
+static b32
+pso_swarm_is_converged(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius)
+{
+    /* Function to check the early termination criteria of the swarm: the global best has not been
+       improved for stall_limit iterations, or the best positions of all particles are within the
+       spread_tol pixels (in both directions). Swarm without feasible position is never converged */
+
+    u32 i, j;
+    u32 n_pad = pso->n_pop_pad; /* Length of the one lane (padded population) */
+    f32 lo, hi; /* Range of the particles best positions along the current variable */
+    f32 scale[2]; /* Scale of the normalized position to pixels for every variable */
+    f32 *lane_best;
+
+    if (!swarm->is_solution_found) {
+        return false;
+    }
+    if ((pso->stall_limit > 0) && (swarm->stall_iterations >= pso->stall_limit)) {
+        return true;
+    }
+    if (pso->spread_tol <= 0.0f) {
+        return false;
+    }
+
+    scale[0] = (f32)(box->BR_in.x - box->BL_in.x - 2 * radius);
+    scale[1] = (f32)(box->UL_in.y - box->BL_in.y - 2 * radius);
+    for (j = 0; j < pso->n_var; ++j) {
+        lane_best = swarm->part_best_positions + j * n_pad;
+        lo = lane_best[0];
+        hi = lane_best[0];
+        for (i = 1; i < pso->n_pop; ++i) {
+            if (lane_best[i] < lo) lo = lane_best[i];
+            if (lane_best[i] > hi) hi = lane_best[i];
         }
-        else {
-            pso->iteration += 1;
-        }                
+        if ((hi - lo) * scale[j] > pso->spread_tol) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static f32
+pso_rnd_position(PSO_t *pso, PSO_swarm_t *swarm)
+{
+    /* Function to generate the random position component in range [var_min, var_max) */
+    return rng_f32_range(&swarm->rng, pso->var_min, pso->var_max);
+}
+
+static void
+pso_random_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius, f32 *position)
+{
+    /* Function to generate the random position (normalized 0.0 - 1.0) of the particle: uniform over
+       the whole box or, with the open sampling, uniform in the random open tile of the box */
+
+    u32 tile;
+    f32 x, y;
+    f32 left_border, right_border, top_border, bottom_border;
+
+    if ((!pso->use_open_sampling) || (0 == box->open_tiles_num)) {
+        position[0] = pso_rnd_position(pso, swarm);
+        position[1] = pso_rnd_position(pso, swarm);
+        return;
     }
 
-    return result;
+    tile = box->open_tiles[rng_u32(&swarm->rng) % box->open_tiles_num];
+    x = (f32)(box->BL_in.x + (tile % box->tiles_x_num) * BOX_TILE_SIDE) +
+        rng_f32_range(&swarm->rng, 0.0f, (f32)BOX_TILE_SIDE);
+    y = (f32)(box->BL_in.y + (tile / box->tiles_x_num) * BOX_TILE_SIDE) +
+        rng_f32_range(&swarm->rng, 0.0f, (f32)BOX_TILE_SIDE);
+
+    left_border = (f32)(box->BL_in.x + radius);
+    right_border = (f32)(box->BR_in.x - radius);
+    top_border = (f32)(box->UL_in.y - radius);
+    bottom_border = (f32)(box->BL_in.y + radius);
+
+    position[0] = (x - left_border) / (right_border - left_border);
+    position[1] = (y - bottom_border) / (top_border - bottom_border);
+
+    /* Keep the position inside the searching range */
+    position[0] = (position[0] < pso->var_min) ? pso->var_min : position[0];
+    position[0] = (position[0] > pso->var_max) ? pso->var_max : position[0];
+    position[1] = (position[1] < pso->var_min) ? pso->var_min : position[1];
+    position[1] = (position[1] > pso->var_max) ? pso->var_max : position[1];
 }
 
-f32
-pso_calculate_cost(PSO_t *pso, const Box_t *box, const u32 radius)
+static void
+pso_warm_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius, f32 *position)
 {
-    /* Method to calculate cost function for the current circle, taking into account the 
-       box blocks containing the information about already packed circles */
+    /* Function to generate the position (normalized 0.0 - 1.0) within warm_spread pixels from a
+       random warm start point */
 
-    u32 i, j, n;
-    u32 x0, y0; /* Coordinates (in pix) of the center of the tested circle */
-    u32 x1, y1, r1; /* Coordinates (in pix) of the center of the already packed circle and radius*/
-    u32 left_border, right_border, top_border, bottom_border;
-    V2_u32_t block_BL, block_UR; /* BL and UR points of outside rectangle of the block */
-    V2_u32_t circ_BL, circ_UR; /* BL and UR points of outside rectangle of the circle */ 
-    f32 distance; /* Distance between the circles centers (in pix) */
-    Circles_list_t* circles_list; /* Circles list from where we have to check the circles */
-    Circles_list_elem_t *list_elem; /* Element of the circles list */
-        
-    /* 1. Determination of the center coordinates of circle to be tested (0-1 -> pixels) */
-    /* Determination of boarders of the coordinates change */
-    left_border = box->BL_in.x + radius;
-    right_border = box->BR_in.x - radius;
-    top_border = box->UL_in.y - radius;
-    bottom_border = box->BL_in.y + radius;
+    V2_u32_t point;
+    f32 x, y;
+    f32 left_border, right_border, top_border, bottom_border;
+
+    point = pso->warm_points[rng_u32(&swarm->rng) % pso->warm_points_num];
+    x = (f32)point.x + rng_f32_range(&swarm->rng, -(f32)pso->warm_spread, (f32)pso->warm_spread);
+    y = (f32)point.y + rng_f32_range(&swarm->rng, -(f32)pso->warm_spread, (f32)pso->warm_spread);
+
+    left_border = (f32)(box->BL_in.x + radius);
+    right_border = (f32)(box->BR_in.x - radius);
+    top_border = (f32)(box->UL_in.y - radius);
+    bottom_border = (f32)(box->BL_in.y + radius);
+
+    position[0] = (x - left_border) / (right_border - left_border);
+    position[1] = (y - bottom_border) / (top_border - bottom_border);
+
+    /* Keep the position inside the searching range */
+    position[0] = (position[0] < pso->var_min) ? pso->var_min : position[0];
+    position[0] = (position[0] > pso->var_max) ? pso->var_max : position[0];
+    position[1] = (position[1] < pso->var_min) ? pso->var_min : position[1];
+    position[1] = (position[1] > pso->var_max) ? pso->var_max : position[1];
+}
+
+static void
+pso_surface_position(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius, f32 *position)
+{
+    /* Function to generate the position (normalized 0.0 - 1.0) at the random column within
+       surface_spread pixels above the skyline of the box */
+
+    f32 y;
+    f32 top_border, bottom_border;
+    V2_u32_t pixel;
+
+    position[0] = pso_rnd_position(pso, swarm);
+    position[1] = 0.0f;
+    pixel = pso_calc_coordinates(box, radius, position);
+    y = (f32)(box_surface_y(box, pixel.x, radius) + radius) +
+        rng_f32_range(&swarm->rng, 0.0f, (f32)pso->surface_spread);
+
+    top_border = (f32)(box->UL_in.y - radius);
+    bottom_border = (f32)(box->BL_in.y + radius);
+    position[1] = (y - bottom_border) / (top_border - bottom_border);
+
+    /* Keep the position inside the searching range */
+    position[1] = (position[1] < pso->var_min) ? pso->var_min : position[1];
+    position[1] = (position[1] > pso->var_max) ? pso->var_max : position[1];
+}
+
+static void
+pso_add_warm_point(PSO_t *pso, const V2_u32_t point)
+{
+    /* Function to add the point into the ring of warm start points (the oldest one is replaced) */
+    pso->warm_points[pso->warm_points_next] = point;
+    pso->warm_points_next = (pso->warm_points_next + 1) % pso->warm_points_capacity;
+    if (pso->warm_points_num < pso->warm_points_capacity) {
+        pso->warm_points_num += 1;
+    }
+}
+
+static void
+pso_collect_warm_points(PSO_t *pso, const Box_t *box, const u32 radius, const PSO_result_t *result)
+{
+    /* Function to add the feasible best positions of the best swarm (the free places near the fill
+       front) and the found placement into the ring of warm start points */
+
+    PSO_swarm_t *best_swarm;
+    u32 i, k;
+    f32 position[2];
+
+    best_swarm = &pso->swarms[0];
+    for (k = 1; k < pso->n_islands; ++k) {
+        if (pso->swarms[k].global_best_cost < best_swarm->global_best_cost) {
+            best_swarm = &pso->swarms[k];
+        }
+    }
+
+    for (i = 0; i < pso->n_pop; ++i) {
+        if (best_swarm->part_best_costs[i] < large_f32) {
+            position[0] = best_swarm->part_best_positions[i];
+            position[1] = best_swarm->part_best_positions[pso->n_pop_pad + i];
+            pso_add_warm_point(pso, pso_calc_coordinates(box, radius, position));
+        }
+    }
+    pso_add_warm_point(pso, result->global_best_coordinates);
+}
+
+static void
+pso_evaluate_swarm(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius)
+{
+    /* Function to calculate the current costs of all particles in the swarm. The costs of the cache
+       hits are resolved serially, only the misses are evaluated. With the thread pool and the only
+       island the misses are split into chunks evaluated in parallel, the bests are reduced after
+       the barrier */
+
+    PSO_eval_job_t job;
+    u32 i, tasks_num;
+
+    if (pso->use_cache) {
+        pso_cache_lookup(pso, swarm, box, radius);
+    }
+    else {
+        for (i = 0; i < pso->n_pop; ++i) {
+            swarm->eval_indices[i] = i;
+        }
+        swarm->eval_num = pso->n_pop;
+    }
+
+    if (pso->use_pruning) {
+        pso_prune(pso, swarm, box, radius);
+    }
 
-    /* Calculation of the center coordinates */
-    x0 = (u32)roundf(pso->tmp_position[0] * (right_border - left_border) + left_border);
-    y0 = (u32)roundf(pso->tmp_position[1] * (top_border - bottom_border) + bottom_border);
+    if ((NULL == pso->thread_pool) || (pso->n_islands > 1) || (swarm->eval_num <= PSO_EVAL_CHUNK)) {
+        pso_evaluate_range(pso, swarm, box, radius, 0, swarm->eval_num);
+    }
+    else {
+        job.pso = pso;
+        job.swarm = swarm;
+        job.box = box;
+        job.radius = radius;
+        tasks_num = (swarm->eval_num + PSO_EVAL_CHUNK - 1) / PSO_EVAL_CHUNK;
+        thread_pool_run(pso->thread_pool, pso_evaluate_task, &job, tasks_num);
+    }
 
-    /* 2. Determination of the outer rectangle of the tested circle */
-    circ_BL.x = x0 - radius;
-    circ_BL.y = y0 - radius;
-    circ_UR.x = x0 + radius;
-    circ_UR.y = y0 + radius;
+    if (pso->use_cache) {
+        pso_cache_store(pso, swarm);
+    }
+}
 
-    /* 3. Test for interception with packed circles from the necessary box blocks */
-    for (i = 0; i < box->blocks_side_num; ++i) {
-        for (j = 0; j < box->blocks_side_num; ++j) {
+static void
+pso_prune(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius)
+{
+    /* Function to remove from the evaluation list the particles which can't improve their best
+       costs (nor the global best). Their candidates are resolved by the skyline: above it they are
+       feasible, otherwise they are treated as the interception. The results depend on the best cost
+       of the particle, so they are not stored into the cache */
 
-            /* Determine the parameters of the outside rectangle of the current block */
-            block_BL.x = box->blocks[i][j].BL.x;
-            block_BL.y = box->blocks[i][j].BL.y;
-            block_UR.x = box->blocks[i][j].UR.x;
-            block_UR.y = box->blocks[i][j].UR.y;
+    u32 i, k, n;
+    f32 position[2];
+    f32 cost;
+    b32 is_above; /* Flag that the circle is above the skyline */
+    V2_u32_t pixel;
 
-            /* Check the collision of the outside rectangles (if not, check next block) */
-            if (!rectangles_are_collide(circ_BL, circ_UR, block_BL, block_UR)) {
+    n = 0;
+    for (k = 0; k < swarm->eval_num; ++k) {
+        i = swarm->eval_indices[k];
+
+        /* Particle without the feasible best position is always checked */
+        if (swarm->part_best_costs[i] < large_f32) {
+            if (pso->use_cache) {
+                pixel.x = swarm->part_pixels[i];
+                pixel.y = swarm->part_pixels[pso->n_pop_pad + i];
+            }
+            else {
+                position[0] = swarm->part_positions[i];
+                position[1] = swarm->part_positions[pso->n_pop_pad + i];
+                pixel = pso_calc_coordinates(box, radius, position);
+            }
+
+            cost = box_center_cost(box, pixel.x, pixel.y);
+            if (cost >= swarm->part_best_costs[i]) {
+                is_above = (pixel.y >= radius) && (pixel.y - radius >= box_surface_y(box, pixel.x, radius));
+                swarm->part_costs[i] = is_above ? cost : large_f32;
+                swarm->part_feasible[i] = is_above;
+                swarm->pruned_num += 1;
                 continue;
             }
+        }
 
-            /* Copy the pointer to the block circles list to the memporary variable */
-            circles_list = box->blocks[i][j].circles_list;
+        swarm->eval_indices[n] = i;
+        n += 1;
+    }
+    swarm->eval_num = n;
+}
 
-            /* Check the circles from the block circles list */
-            if (circles_list->size > 0) {
-                list_elem = circles_list->head;
-        
-                for (n = 0; n < circles_list->size; ++n) {
-                    /* Coordinates of the circle found in the list  */
-                    x1 = list_elem->circle->center.x;
-                    y1 = list_elem->circle->center.y;
-                    r1 = list_elem->circle->radius;
-            
-                    /* Calculate distance between the centers of the circles */
-                    distance = sqrtf(powf(((f32)x0 - (f32)x1), 2) + powf(((f32)y0 - (f32)y1), 2));
-
-                    if (distance <= ((f32)radius + (f32)r1)) {
-                        /* Interception is detected, returning INFINITY */
-                        return large_f32;
-                    }
-                    /* Check the next circle for the collision */
-                    list_elem = list_elem->next;
-                }
-            }
-        } /* for j */
-    } /* for i */
+static void
+pso_evaluate_task(void *task_ctx, u32 task_index)
+{
+    /* Task of the parallel costs evaluation: one chunk of the particles to be evaluated */
+
+    PSO_eval_job_t *job = (PSO_eval_job_t *)task_ctx;
+    u32 first, last;
+
+    first = task_index * PSO_EVAL_CHUNK;
+    last = first + PSO_EVAL_CHUNK;
+    if (last > job->swarm->eval_num) last = job->swarm->eval_num;
+
+    pso_evaluate_range(job->pso, job->swarm, job->box, job->radius, first, last);
+}
+
+static void
+pso_evaluate_range(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius, const u32 first,
+                   const u32 last)
+{
+    /* Function to calculate the costs of the particles first...last-1 of the evaluation list by one
+       batch query of the box. Writes only to the own elements of the arrays, so the different
+       ranges can be evaluated concurrently */
+
+    u32 i, k;
+    u32 *xs, *ys; /* Centers of the evaluated particles */
+    f32 position[2];
+    V2_u32_t pixel;
+
+    xs = swarm->eval_pixels;
+    ys = swarm->eval_pixels + pso->n_pop_pad;
+    for (k = first; k < last; ++k) {
+        i = swarm->eval_indices[k];
+        if (pso->use_cache) {
+            /* Pixel is already calculated by the cache lookup */
+            pixel.x = swarm->part_pixels[i];
+            pixel.y = swarm->part_pixels[pso->n_pop_pad + i];
+        }
+        else {
+            position[0] = swarm->part_positions[i];
+            position[1] = swarm->part_positions[pso->n_pop_pad + i];
+            pixel = pso_calc_coordinates(box, radius, position);
+        }
+        /* Batch query takes the centers in the geometry units */
+        xs[k] = pixel.x << box->subpixel_bits;
+        ys[k] = pixel.y << box->subpixel_bits;
+    }
+
+    box_query_batch(box, radius, last - first, xs + first, ys + first, swarm->eval_costs + first,
+                    swarm->eval_feasible + first);
+
+    for (k = first; k < last; ++k) {
+        i = swarm->eval_indices[k];
+        swarm->part_costs[i] = swarm->eval_costs[k];
+        swarm->part_feasible[i] = swarm->eval_feasible[k];
+    }
+}
 
-    /* 4. If interception check has passed then calculate the cost value distance from the circle 
-          center to the middle bottom point*/
-    pso->is_solution_found = true;
-    x1 = (box->BL_in.x + box->BR_in.x) / 2;
-    y1 = box->BL_in.y;
+static u32
+pso_cache_hash(const u32 x, const u32 y)
+{
+    /* Function to calculate the hash of the pixel (index of the first probed cache entry) */
+    u32 h;
+
+    h = x * 0x9e3779b1u ^ y * 0x85ebca77u;
+    h ^= h >> 15;
+    return h & (PSO_CACHE_SIZE - 1);
+}
+
+static void
+pso_cache_lookup(PSO_t *pso, PSO_swarm_t *swarm, const Box_t *box, const u32 radius)
+{
+    /* Function to calculate the pixels of all particles and take the costs of the visited pixels
+       from the cache. Particles not found in the cache are put into the evaluation list */
+
+    u32 i, h;
+    u32 x, y;
+    f32 position[2];
+    V2_u32_t pixel;
+    PSO_cache_entry_t *entry;
+
+    swarm->eval_num = 0;
+    for (i = 0; i < pso->n_pop; ++i) {
+        position[0] = swarm->part_positions[i];
+        position[1] = swarm->part_positions[pso->n_pop_pad + i];
+        pixel = pso_calc_coordinates(box, radius, position);
+        x = pixel.x;
+        y = pixel.y;
+        swarm->part_pixels[i] = x;
+        swarm->part_pixels[pso->n_pop_pad + i] = y;
+
+        /* Linear probing till the pixel or the empty entry */
+        h = pso_cache_hash(x, y);
+        entry = &swarm->cache[h];
+        while ((entry->generation == swarm->cache_generation) && ((entry->x != x) || (entry->y != y))) {
+            h = (h + 1) & (PSO_CACHE_SIZE - 1);
+            entry = &swarm->cache[h];
+        }
+
+        if (entry->generation == swarm->cache_generation) {
+            swarm->part_costs[i] = entry->cost;
+            swarm->part_feasible[i] = entry->is_feasible;
+            swarm->cache_hits += 1;
+        }
+        else {
+            swarm->eval_indices[swarm->eval_num] = i;
+            swarm->eval_num += 1;
+            swarm->cache_misses += 1;
+        }
+    }
+}
+
+static void
+pso_cache_store(PSO_t *pso, PSO_swarm_t *swarm)
+{
+    /* Function to store the costs of the evaluated particles into the cache (till it is filled up
+       to the maximum load, after that the cache is only read) */
+
+    u32 i, k, h;
+    u32 x, y;
+    PSO_cache_entry_t *entry;
+
+    for (k = 0; (k < swarm->eval_num) && (swarm->cache_used < PSO_CACHE_MAX_USED); ++k) {
+        i = swarm->eval_indices[k];
+        x = swarm->part_pixels[i];
+        y = swarm->part_pixels[pso->n_pop_pad + i];
 
-    /* Distance to the middle bottom point of the box */
-    distance = sqrtf(powf(((f32)x0 - (f32)x1), 2) + powf(((f32)y0 - (f32)y1), 2));
+        h = pso_cache_hash(x, y);
+        entry = &swarm->cache[h];
+        while ((entry->generation == swarm->cache_generation) && ((entry->x != x) || (entry->y != y))) {
+            h = (h + 1) & (PSO_CACHE_SIZE - 1);
+            entry = &swarm->cache[h];
+        }
+
+        /* The same pixel can be evaluated by several particles of the iteration */
+        if (entry->generation != swarm->cache_generation) {
+            entry->x = x;
+            entry->y = y;
+            entry->generation = swarm->cache_generation;
+            entry->is_feasible = swarm->part_feasible[i];
+            entry->cost = swarm->part_costs[i];
+            swarm->cache_used += 1;
+        }
+    }
+}
+
+static void
+pso_update_bests(PSO_t *pso, PSO_swarm_t *swarm)
+{
+    /* Function to update the personal best positions (vectorized by lanes), personal best costs and
+       the global best cost and position after the swarm costs evaluation */
+
+    u32 i, j;
+    u32 best_i; /* Index of the best particle in the current iteration */
+
+    /* Update the best positions and reset the particles with interception to their best
+       positions (this has to be done before the update of the best costs) */
+    for (j = 0; j < pso->n_var; ++j) {
+        pso_update_bests_lane(pso->n_pop_pad, swarm->part_positions + j * pso->n_pop_pad,
+                              swarm->part_velocities + j * pso->n_pop_pad,
+                              swarm->part_best_positions + j * pso->n_pop_pad,
+                              swarm->part_costs, swarm->part_best_costs);
+    }
 
-    /* And distance to the bottom of the box */
-    distance += (f32)y0;
+    /* Update the particles best costs and find the best particle of the iteration */
+    best_i = pso->n_pop;
+    for (i = 0; i < pso->n_pop; ++i) {
+        if (!swarm->part_feasible[i]) {
+            swarm->infeasible_num += 1;
+        }
+        if (swarm->part_costs[i] < swarm->part_best_costs[i]) {
+            swarm->part_best_costs[i] = swarm->part_costs[i];
+        }
+        if (swarm->part_costs[i] < swarm->global_best_cost) {
+            swarm->global_best_cost = swarm->part_costs[i];
+            best_i = i;
+        }
+    }
 
-    assert(distance > 0.0f);
-    return distance;
-}  
+    /* Update the global best position (it is equal to the best position of the best particle) */
+    if (best_i < pso->n_pop) {
+        for (j = 0; j < pso->n_var; ++j) {
+            swarm->global_best_position[j] = swarm->part_best_positions[j * pso->n_pop_pad + best_i];
+        }
+    }
+
+    /* Solution is the global best position with the real cost (also the migrated one) */
+    swarm->is_solution_found = (swarm->global_best_cost < large_f32);
+}
 
 V2_u32_t
-pso_calc_coordinates(PSO_t *pso, const Box_t *box, const u32 radius)
+pso_calc_coordinates(const Box_t *box, const u32 radius, const f32 *position)
 {
-    /* Method to calculate the coordinates from the found best solution */
+    /* Method to calculate the coordinates (in pix) from the found best position */
 
     u32 x, y;
     u32 left_border, right_border, top_border, bottom_border;
@@ -351,11 +1243,8 @@ pso_calc_coordinates(PSO_t *pso, const Box_t *box, const u32 radius)
     top_border = box->UL_in.y - radius;
     bottom_border = box->BL_in.y + radius;
 
-    //printf("%f %f\n", pso->global_best_position[0],
-    //       pso->global_best_position[1]);  
-    
-    x = (u32)roundf(pso->global_best_position[0] * (right_border - left_border) + left_border);
-    y = (u32)roundf(pso->global_best_position[1] * (top_border - bottom_border) + bottom_border);
+    x = (u32)roundf(position[0] * (right_border - left_border) + left_border);
+    y = (u32)roundf(position[1] * (top_border - bottom_border) + bottom_border);
 
     result.x = x;
     result.y = y;
@@ -0,0 +1,271 @@
+/*================================================================================*/
+/* Realization of quadtree methods                                                */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+
+/* Program includes: */
+#include <quadtree.h>
+#include <utils.h>
+#include <circle.h>
+#include <misc.h>
+
+/* Size of the stack of the nodes to visit by the query (enough for the depth of 32 levels) */
+#define QUADTREE_STACK_SIZE 128
+
+/* Static functions */
+/* Function to get the new node (the records memory of the previously used node is kept) */
+static u32 quadtree_new_node(Quadtree_t *quadtree, const u32 x_min, const u32 y_min, const u32 half);
+/* Function to find (and create if needed) the node where the record should be stored */
+static u32 quadtree_locate(Quadtree_t *quadtree, const Circle_record_t *record);
+/* Function to reserve the records array of the node */
+static void quadtree_reserve(Quadtree_node_t *node, const u32 capacity);
+
+Quadtree_t*
+quadtree_create(void)
+{
+    /* Method for creation of the empty quadtree object (malloc). Nodes are allocated at the
+       initialization, when the covered rectangle is known */
+    Quadtree_t *tmp_quadtree;
+
+    tmp_quadtree = (Quadtree_t *) calloc (1, sizeof(Quadtree_t));
+    if (NULL == tmp_quadtree) print_error_and_exit("Error in memory allocation!\n");
+
+    return tmp_quadtree;
+}
+
+void
+quadtree_delete(Quadtree_t *quadtree)
+{
+    /* Method for deleting the quadtree object (free) */
+    u32 i;
+
+    for (i = 0; i < quadtree->nodes_capacity; ++i) {
+        free(quadtree->nodes[i].records);
+    }
+    free(quadtree->nodes);
+    free(quadtree);
+}
+
+void
+quadtree_init(Quadtree_t *quadtree, const u32 x_min, const u32 y_min, const u32 width,
+              const u32 height, const u32 min_half)
+{
+    /* Initialization (reset) of the quadtree. The root square is the smallest power of two
+       covering all the centers of the rectangle (the side is inclusive) */
+    u32 side;
+
+    side = 1;
+    while ((side <= width) || (side <= height)) {
+        side *= 2;
+    }
+
+    quadtree->nodes_num = 0;
+    quadtree->records_num = 0;
+    quadtree->min_half = (min_half > 0) ? min_half : 1;
+    quadtree_new_node(quadtree, x_min, y_min, (side > 1) ? side / 2 : 1);
+}
+
+static u32
+quadtree_new_node(Quadtree_t *quadtree, const u32 x_min, const u32 y_min, const u32 half)
+{
+    /* Function to get the new node at the end of the nodes array (array grows twice). Returns
+       the index of the node */
+    Quadtree_node_t *tmp_nodes;
+    Quadtree_node_t *node;
+    u32 i;
+
+    if (quadtree->nodes_num == quadtree->nodes_capacity) {
+        i = quadtree->nodes_capacity;
+        quadtree->nodes_capacity = (quadtree->nodes_capacity > 0) ? 2 * quadtree->nodes_capacity : 64;
+        tmp_nodes = (Quadtree_node_t *) realloc (quadtree->nodes,
+                                                 quadtree->nodes_capacity * sizeof(Quadtree_node_t));
+        if (NULL == tmp_nodes) print_error_and_exit("Error in memory allocation!\n");
+        quadtree->nodes = tmp_nodes;
+        for (; i < quadtree->nodes_capacity; ++i) {
+            quadtree->nodes[i].records = NULL;
+            quadtree->nodes[i].records_capacity = 0;
+        }
+    }
+
+    node = &quadtree->nodes[quadtree->nodes_num];
+    node->x_min = x_min;
+    node->y_min = y_min;
+    node->half = half;
+    node->max_radius = 0;
+    for (i = 0; i < 4; ++i) {
+        node->children[i] = 0;
+    }
+    node->records_num = 0;
+
+    quadtree->nodes_num += 1;
+    return quadtree->nodes_num - 1;
+}
+
+static u32
+quadtree_locate(Quadtree_t *quadtree, const Circle_record_t *record)
+{
+    /* Function to find the deepest node containing the center, which half side is not less than
+       the radius (and min_half). Missing nodes on the way are created, the largest radiuses of the
+       subtrees on the way are updated */
+    u32 index, child, quadrant, half;
+    u32 x_min, y_min;
+
+    index = 0;
+    while (true) {
+        if (record->radius > quadtree->nodes[index].max_radius) {
+            quadtree->nodes[index].max_radius = record->radius;
+        }
+        half = quadtree->nodes[index].half;
+        if ((half / 2 < record->radius) || (half / 2 < quadtree->min_half)) {
+            return index;
+        }
+
+        /* Quadrant of the center (the centers outside the root are clamped to the border ones) */
+        x_min = quadtree->nodes[index].x_min;
+        y_min = quadtree->nodes[index].y_min;
+        quadrant = 0;
+        if (record->x >= x_min + half) {
+            quadrant += 1;
+            x_min += half;
+        }
+        if (record->y >= y_min + half) {
+            quadrant += 2;
+            y_min += half;
+        }
+
+        child = quadtree->nodes[index].children[quadrant];
+        if (0 == child) {
+            child = quadtree_new_node(quadtree, x_min, y_min, half / 2);
+            quadtree->nodes[index].children[quadrant] = child;
+        }
+        index = child;
+    }
+}
+
+static void
+quadtree_reserve(Quadtree_node_t *node, const u32 capacity)
+{
+    /* Function to reserve the records array of the node for at least capacity records */
+    Circle_record_t *tmp_records;
+
+    if (capacity <= node->records_capacity) {
+        return;
+    }
+    tmp_records = (Circle_record_t *) realloc (node->records, capacity * sizeof(Circle_record_t));
+    if (NULL == tmp_records) print_error_and_exit("Error in memory allocation!\n");
+    node->records = tmp_records;
+    node->records_capacity = capacity;
+}
+
+void
+quadtree_insert(Quadtree_t *quadtree, const Circle_record_t *record)
+{
+    /* Method for the incremental insert of the circle record (records array of the node grows
+       twice) */
+    Quadtree_node_t *node;
+    u32 index;
+
+    /* Locate can reallocate the nodes array, so the node is taken after it */
+    index = quadtree_locate(quadtree, record);
+    node = &quadtree->nodes[index];
+    if (node->records_num == node->records_capacity) {
+        quadtree_reserve(node, (node->records_capacity > 0) ? 2 * node->records_capacity : 8);
+    }
+    node->records[node->records_num] = *record;
+    node->records_num += 1;
+    quadtree->records_num += 1;
+}
+
+void
+quadtree_build(Quadtree_t *quadtree, const Circle_record_t *records, const u32 records_num)
+{
+    /* Method for the bulk build of the tree (root square is kept). The first pass creates the
+       nodes and counts their records, then every records array is reserved once and filled by
+       the nodes found by the first pass */
+    u32 i, x_min, y_min, half;
+    u32 *indices; /* Nodes of the records */
+    Quadtree_node_t *node;
+
+    indices = (u32 *) malloc (((size_t)records_num + 1) * sizeof(u32));
+    if (NULL == indices) print_error_and_exit("Error in memory allocation!\n");
+
+    x_min = quadtree->nodes[0].x_min;
+    y_min = quadtree->nodes[0].y_min;
+    half = quadtree->nodes[0].half;
+    quadtree->nodes_num = 0;
+    quadtree_new_node(quadtree, x_min, y_min, half);
+
+    for (i = 0; i < records_num; ++i) {
+        indices[i] = quadtree_locate(quadtree, &records[i]);
+        quadtree->nodes[indices[i]].records_num += 1;
+    }
+
+    for (i = 0; i < quadtree->nodes_num; ++i) {
+        quadtree_reserve(&quadtree->nodes[i], quadtree->nodes[i].records_num);
+        quadtree->nodes[i].records_num = 0;
+    }
+
+    for (i = 0; i < records_num; ++i) {
+        node = &quadtree->nodes[indices[i]];
+        node->records[node->records_num] = records[i];
+        node->records_num += 1;
+    }
+    quadtree->records_num = records_num;
+
+    free(indices);
+}
+
+b32
+quadtree_query(const Quadtree_t *quadtree, const u32 x0, const u32 y0, const u32 reach,
+               Quadtree_visit_fn_t visit, void *data)
+{
+    /* Method to visit the records of the nodes which loose squares intersect the query square.
+       Returns true if the query was stopped by the callback */
+    u32 stack[QUADTREE_STACK_SIZE];
+    u32 stack_num, index, i;
+    s64 q_left, q_right, q_bottom, q_top;
+    s64 side, margin;
+    const Quadtree_node_t *node;
+
+    if (0 == quadtree->nodes_num) {
+        return false;
+    }
+
+    q_left = (s64)x0 - (s64)reach;
+    q_right = (s64)x0 + (s64)reach;
+    q_bottom = (s64)y0 - (s64)reach;
+    q_top = (s64)y0 + (s64)reach;
+
+    stack[0] = 0;
+    stack_num = 1;
+    while (stack_num > 0) {
+        stack_num -= 1;
+        index = stack[stack_num];
+        node = &quadtree->nodes[index];
+
+        /* Loose square of the node: [min - margin, min + side + margin] */
+        side = 2 * (s64)node->half;
+        margin = (s64)node->max_radius;
+        if ((q_right < (s64)node->x_min - margin) || (q_left > (s64)node->x_min + side + margin) ||
+            (q_top < (s64)node->y_min - margin) || (q_bottom > (s64)node->y_min + side + margin)) {
+            continue;
+        }
+
+        for (i = 0; i < node->records_num; ++i) {
+            if (visit(data, &node->records[i])) {
+                return true;
+            }
+        }
+
+        for (i = 0; i < 4; ++i) {
+            if (0 != node->children[i]) {
+                stack[stack_num] = node->children[i];
+                stack_num += 1;
+            }
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,154 @@
+/*================================================================================*/
+/* Realization of rng methods (xoshiro128+ generators seeded with splitmix64)     */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+
+/* Program includes: */
+#include <rng.h>
+#include <utils.h>
+
+#if defined(__SSE2__)
+#define RNG_SSE2
+#include <emmintrin.h>
+#endif
+
+/* Static functions */
+static u64 rng_splitmix64(u64 *state);
+static void rng_step(Rng_t *rng, u32 *out);
+
+/* Multiplier to convert 24 upper bits of u32 number to the float in range [0.0, 1.0) */
+static const f32 rng_f32_mul = 1.0f / 16777216.0f;
+
+static u64
+rng_splitmix64(u64 *state)
+{
+    /* Function of the splitmix64 generator (used to expand the seed into the states) */
+    u64 z;
+
+    *state += 0x9e3779b97f4a7c15ull;
+    z = *state;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+void
+rng_seed(Rng_t *rng, const u64 seed, const u64 stream)
+{
+    /* Method to seed the generator. Different stream numbers give independent sequences, so every
+       thread (swarm, run and so on) should use its own stream of the same seed */
+
+    u64 sm_state;
+    u64 value;
+    u32 w, l;
+
+    sm_state = seed ^ (stream * 0xd1b54a32d192ed03ull);
+    for (l = 0; l < RNG_LANES; ++l) {
+        for (w = 0; w < 4; w += 2) {
+            value = rng_splitmix64(&sm_state);
+            rng->s[w][l] = (u32)value;
+            rng->s[w + 1][l] = (u32)(value >> 32);
+        }
+        /* State of xoshiro generator must not be all zeros */
+        if ((rng->s[0][l] | rng->s[1][l] | rng->s[2][l] | rng->s[3][l]) == 0) {
+            rng->s[0][l] = 1;
+        }
+    }
+    rng->out_index = RNG_LANES;
+}
+
+static void
+rng_step(Rng_t *rng, u32 *out)
+{
+    /* Function to advance all the generators by one step (xoshiro128+) and get their outputs */
+
+    u32 l, t;
+
+    for (l = 0; l < RNG_LANES; ++l) {
+        out[l] = rng->s[0][l] + rng->s[3][l];
+        t = rng->s[1][l] << 9;
+        rng->s[2][l] ^= rng->s[0][l];
+        rng->s[3][l] ^= rng->s[1][l];
+        rng->s[1][l] ^= rng->s[2][l];
+        rng->s[0][l] ^= rng->s[3][l];
+        rng->s[2][l] ^= t;
+        rng->s[3][l] = (rng->s[3][l] << 11) | (rng->s[3][l] >> 21);
+    }
+}
+
+u32
+rng_u32(Rng_t *rng)
+{
+    /* Method to generate the random u32 number */
+
+    if (rng->out_index >= RNG_LANES) {
+        rng_step(rng, rng->out);
+        rng->out_index = 0;
+    }
+    return rng->out[rng->out_index++];
+}
+
+f32
+rng_f32(Rng_t *rng)
+{
+    /* Method to generate the random number in range [0.0, 1.0) (24 bits of resolution) */
+    return (f32)(rng_u32(rng) >> 8) * rng_f32_mul;
+}
+
+f32
+rng_f32_range(Rng_t *rng, const f32 left_bnd, const f32 right_bnd)
+{
+    /* Method to generate the random f32 number from specific range [left_bnd, right_bnd) */
+    return left_bnd + rng_f32(rng) * (right_bnd - left_bnd);
+}
+
+void
+rng_fill_f32(Rng_t *rng, f32 *buffer, const u32 N)
+{
+    /* Method to fill the buffer with N random numbers in range [0.0, 1.0). The full steps are done
+       with SSE2 (all generators at once), the result is the same as for N calls of rng_f32 */
+
+    u32 i = 0;
+#ifdef RNG_SSE2
+    __m128i s0, s1, s2, s3, t, result;
+    const __m128 mul = _mm_set1_ps(rng_f32_mul);
+#endif
+
+    /* Consume the numbers left from the previous step */
+    while ((i < N) && (rng->out_index < RNG_LANES)) {
+        buffer[i++] = (f32)(rng->out[rng->out_index++] >> 8) * rng_f32_mul;
+    }
+
+#ifdef RNG_SSE2
+    if (N - i >= RNG_LANES) {
+        s0 = _mm_loadu_si128((__m128i *)rng->s[0]);
+        s1 = _mm_loadu_si128((__m128i *)rng->s[1]);
+        s2 = _mm_loadu_si128((__m128i *)rng->s[2]);
+        s3 = _mm_loadu_si128((__m128i *)rng->s[3]);
+
+        for (; N - i >= RNG_LANES; i += RNG_LANES) {
+            result = _mm_add_epi32(s0, s3);
+            t = _mm_slli_epi32(s1, 9);
+            s2 = _mm_xor_si128(s2, s0);
+            s3 = _mm_xor_si128(s3, s1);
+            s1 = _mm_xor_si128(s1, s2);
+            s0 = _mm_xor_si128(s0, s3);
+            s2 = _mm_xor_si128(s2, t);
+            s3 = _mm_or_si128(_mm_slli_epi32(s3, 11), _mm_srli_epi32(s3, 21));
+            _mm_storeu_ps(buffer + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(result, 8)), mul));
+        }
+
+        _mm_storeu_si128((__m128i *)rng->s[0], s0);
+        _mm_storeu_si128((__m128i *)rng->s[1], s1);
+        _mm_storeu_si128((__m128i *)rng->s[2], s2);
+        _mm_storeu_si128((__m128i *)rng->s[3], s3);
+    }
+#endif
+
+    /* Rest of the numbers (and all of them without SSE2) */
+    while (i < N) {
+        buffer[i++] = rng_f32(rng);
+    }
+}
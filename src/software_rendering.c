@@ -9,14 +9,17 @@
 #include <software_rendering.h>
 #include <utils.h>
 #include <file_io.h>
+#include <misc.h>
 
 /* Static (global in the file) variables and data structures */
-static u32 LSX_array[WINDOW_WIDTH]; /* Left Side X array */
-static u32 RSX_array[WINDOW_WIDTH]; /* Rigth Side X array */
+static u32 *LSX_array = NULL; /* Left Side X array */
+static u32 *RSX_array = NULL; /* Rigth Side X array */
+static u32 SX_capacity = 0; /* Capacity of the side arrays (grow with the height of the triangles) */
 static u32 LSX_i = 0; /* Left Side X array index */
 static u32 RSX_i = 0; /* Right Side X array index */
 
 /* Static functions */
+static void draw_reserve_side_arrays(u32 length);
 static void draw_line_extended(V2_u32_t v0, V2_u32_t v1, u32 color, Render_Buffer_t *render_buffer,
                                u32 *SX_array, u32 *SX_i);
 static void draw_fill_bottom_flat_triangle(V2_u32_t v1, V2_u32_t v2, V2_u32_t v3, u32 color,
@@ -82,10 +85,13 @@ clear_full_screen(u32 color, Render_Buffer_t *render_buffer)
 void
 draw_pixel(u32 x, u32 y, u32 color, Render_Buffer_t *render_buffer)
 {
-    /* Function for drawing a single pixel on the screen */
+    /* Function for drawing a single pixel on the screen (pixels outside of the buffer are skipped,
+       so the objects of the larger world can be drawn partially) */
 
     u32 *pixel = render_buffer->pixels;
-    *(pixel + x + render_buffer->width * y) = color;
+    if ((x < render_buffer->width) && (y < render_buffer->height)) {
+        *(pixel + x + render_buffer->width * y) = color;
+    }
 }
 
 void
@@ -94,7 +100,7 @@ draw_line(u32 x0, u32 y0, u32 x1, u32 y1, u32 color, Render_Buffer_t *render_buf
     /* Function for drawing a pixelized line from one point to another */
     V2_u32_t v0 = {.x = x0, .y = y0};
     V2_u32_t v1 = {.x = x1, .y = y1};
-    draw_line_extended(v0, v1, color, render_buffer, LSX_array, &LSX_i);
+    draw_line_extended(v0, v1, color, render_buffer, NULL, &LSX_i);
 }
 
 void
@@ -104,8 +110,8 @@ draw_hor_line(u32 x0, u32 y0, u32 length, u32 width, u32 color, Render_Buffer_t
     u32 *pixel = render_buffer->pixels;
     u32 x, y;
 
-    for (x = x0; x < (x0 + length); ++x) {
-        for (y = y0; y < (y0 + width); ++y) {
+    for (x = x0; (x < (x0 + length)) && (x < render_buffer->width); ++x) {
+        for (y = y0; (y < (y0 + width)) && (y < render_buffer->height); ++y) {
             *(pixel + x + render_buffer->width * y) = color;
         }
     }
@@ -118,8 +124,8 @@ draw_ver_line(u32 x0, u32 y0, u32 length, u32 width, u32 color, Render_Buffer_t
     u32 *pixel = render_buffer->pixels;
     u32 x, y;
 
-    for (y = y0; y < (y0 + length); ++y) {
-        for (x = x0; x < (x0 + width); ++x) {
+    for (y = y0; (y < (y0 + length)) && (y < render_buffer->height); ++y) {
+        for (x = x0; (x < (x0 + width)) && (x < render_buffer->width); ++x) {
             *(pixel + x + render_buffer->width * y) = color;
         }
     }
@@ -131,7 +137,8 @@ draw_line_extended(V2_u32_t v0, V2_u32_t v1, u32 color, Render_Buffer_t *render_
 {
     /* Function for drawing a pixelized line from one point to another by using
        Brezenham algorithm. This version also record the y coordinates for
-       further rasterization filling of the triangle */
+       further rasterization filling of the triangle (if SX_array is not NULL, it
+       should keep |dy| + 1 values). Pixels outside of the buffer are skipped */
 
     u32 *pixel = render_buffer->pixels;
     s32 xerr = 0, yerr = 0;
@@ -185,10 +192,14 @@ draw_line_extended(V2_u32_t v0, V2_u32_t v1, u32 color, Render_Buffer_t *render_
         if (yerr > d) { 
             yerr -= d; 
             y += incY;
-            SX_array[(*SX_i)++] = x; /* Record x when y has shanged */
+            if (NULL != SX_array) {
+                SX_array[(*SX_i)++] = x; /* Record x when y has shanged */
+            }
         }
 
-        *(pixel + x + render_buffer->width * y) = color;
+        if (((u32)x < render_buffer->width) && ((u32)y < render_buffer->height)) {
+            *(pixel + x + render_buffer->width * y) = color;
+        }
     }
     (*SX_i)--;
 }
@@ -201,8 +212,8 @@ draw_rect(u32 x0, u32 y0, u32 width, u32 height, u32 color, Render_Buffer_t *ren
     u32 x, y;
     u32 *pixel = render_buffer->pixels;
 
-    for(y = y0; y < height + y0; y++) {
-        for (x = x0; x < width + x0; x++) {
+    for(y = y0; (y < height + y0) && (y < render_buffer->height); y++) {
+        for (x = x0; (x < width + x0) && (x < render_buffer->width); x++) {
             *(pixel + x + render_buffer->width * y) = color;
         }
     }
@@ -227,6 +238,25 @@ draw_rect_with_brd(u32 x0, u32 y0, u32 width, u32 height, u32 brd_width, u32 col
     }
 }
 
+static void
+draw_reserve_side_arrays(u32 length)
+{
+    /* Function to grow the side arrays of the triangle filling to keep length values (the arrays
+       are kept for the next triangles) */
+    u32 *tmp_array;
+
+    if (length <= SX_capacity) {
+        return;
+    }
+    tmp_array = (u32 *) realloc (LSX_array, length * sizeof(u32));
+    if (NULL == tmp_array) print_error_and_exit("Error in memory allocation!\n");
+    LSX_array = tmp_array;
+    tmp_array = (u32 *) realloc (RSX_array, length * sizeof(u32));
+    if (NULL == tmp_array) print_error_and_exit("Error in memory allocation!\n");
+    RSX_array = tmp_array;
+    SX_capacity = length;
+}
+
 static void
 draw_fill_bottom_flat_triangle(V2_u32_t v1, V2_u32_t v2, V2_u32_t v3, u32 color,
                                Render_Buffer_t *render_buffer)
@@ -239,6 +269,7 @@ draw_fill_bottom_flat_triangle(V2_u32_t v1, V2_u32_t v2, V2_u32_t v3, u32 color,
     u32 length;
     
     /* Draw the side lines of the triangle */
+    draw_reserve_side_arrays(v1.y - v2.y + 1);
     draw_line_extended(v1, v2, color, render_buffer, LSX_array, &LSX_i);
     draw_line_extended(v1, v3, color, render_buffer, RSX_array, &RSX_i);
 
@@ -264,6 +295,7 @@ draw_fill_top_flat_triangle(V2_u32_t v1, V2_u32_t v2, V2_u32_t v3, u32 color,
     u32 length;
 
     /* Draw the side lines of the triangle */
+    draw_reserve_side_arrays(v2.y - v1.y + 1);
     draw_line_extended(v1, v2, color, render_buffer, LSX_array, &LSX_i);
     draw_line_extended(v1, v3, color, render_buffer, RSX_array, &RSX_i);
 
@@ -0,0 +1,151 @@
+/*================================================================================*/
+/* Realization of thread_pool methods                                             */
+/*================================================================================*/
+
+/* Standard incudes: */
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/* Program includes: */
+#include <thread_pool.h>
+#include <utils.h>
+#include <misc.h>
+
+/* Static functions */
+static void* thread_pool_worker(void *arg);
+static void thread_pool_do_tasks(Thread_pool_t *pool);
+
+Thread_pool_t*
+thread_pool_create(const u32 threads_num)
+{
+    /* Method for creation of the thread pool object with threads_num worker threads (malloc) */
+    Thread_pool_t *tmp_pool;
+    u32 i;
+
+    tmp_pool = (Thread_pool_t *) calloc (1, sizeof(Thread_pool_t));
+    if (NULL == tmp_pool) print_error_and_exit("Error in memory allocation!\n");
+
+    tmp_pool->threads_num = threads_num;
+    tmp_pool->is_stopping = false;
+    tmp_pool->job_id = 0;
+    pthread_mutex_init(&tmp_pool->mutex, NULL);
+    pthread_cond_init(&tmp_pool->job_cond, NULL);
+    pthread_cond_init(&tmp_pool->done_cond, NULL);
+
+    if (threads_num > 0) {
+        tmp_pool->threads = (pthread_t *) calloc (threads_num, sizeof(pthread_t));
+        if (NULL == tmp_pool->threads) print_error_and_exit("Error in memory allocation!\n");
+    }
+
+    for (i = 0; i < threads_num; ++i) {
+        if (pthread_create(&tmp_pool->threads[i], NULL, thread_pool_worker, tmp_pool) != 0) {
+            print_error_and_exit("Error in creation of the worker thread!\n");
+        }
+    }
+
+    return tmp_pool;
+}
+
+void
+thread_pool_delete(Thread_pool_t *pool)
+{
+    /* Method for deleting the thread pool object (joins all worker threads) */
+    u32 i;
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->is_stopping = true;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    for (i = 0; i < pool->threads_num; ++i) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_cond_destroy(&pool->done_cond);
+    pthread_cond_destroy(&pool->job_cond);
+    pthread_mutex_destroy(&pool->mutex);
+    free(pool->threads);
+    free(pool);
+}
+
+void
+thread_pool_run(Thread_pool_t *pool, Thread_pool_task_fn_t task_fn, void *task_ctx, const u32 tasks_num)
+{
+    /* Method to execute tasks_num tasks in parallel and wait until all of them are done. The calling
+       thread takes the tasks as well, so the pool without worker threads executes the job serially */
+
+    pthread_mutex_lock(&pool->mutex);
+    pool->task_fn = task_fn;
+    pool->task_ctx = task_ctx;
+    pool->tasks_num = tasks_num;
+    pool->next_task = 0;
+    pool->tasks_done = 0;
+    pool->job_id += 1;
+    pthread_cond_broadcast(&pool->job_cond);
+    pthread_mutex_unlock(&pool->mutex);
+
+    thread_pool_do_tasks(pool);
+
+    /* Barrier: wait for the tasks being executed by the worker threads */
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->tasks_done < pool->tasks_num) {
+        pthread_cond_wait(&pool->done_cond, &pool->mutex);
+    }
+    pool->task_fn = NULL;
+    pool->task_ctx = NULL;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void
+thread_pool_do_tasks(Thread_pool_t *pool)
+{
+    /* Function to take and execute the tasks of the current job until there are no tasks left */
+
+    Thread_pool_task_fn_t task_fn;
+    void *task_ctx;
+    u32 task_index;
+
+    pthread_mutex_lock(&pool->mutex);
+    while (pool->next_task < pool->tasks_num) {
+        task_index = pool->next_task;
+        pool->next_task += 1;
+        task_fn = pool->task_fn;
+        task_ctx = pool->task_ctx;
+        pthread_mutex_unlock(&pool->mutex);
+
+        task_fn(task_ctx, task_index);
+
+        pthread_mutex_lock(&pool->mutex);
+        pool->tasks_done += 1;
+        if (pool->tasks_done == pool->tasks_num) {
+            pthread_cond_signal(&pool->done_cond);
+        }
+    }
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static void*
+thread_pool_worker(void *arg)
+{
+    /* Main function of the worker thread: wait for the new job and take its tasks */
+
+    Thread_pool_t *pool = (Thread_pool_t *)arg;
+    u32 last_job_id = 0;
+
+    for (;;) {
+        pthread_mutex_lock(&pool->mutex);
+        while ((pool->job_id == last_job_id) && !pool->is_stopping) {
+            pthread_cond_wait(&pool->job_cond, &pool->mutex);
+        }
+        if (pool->is_stopping) {
+            pthread_mutex_unlock(&pool->mutex);
+            break;
+        }
+        last_job_id = pool->job_id;
+        pthread_mutex_unlock(&pool->mutex);
+
+        thread_pool_do_tasks(pool);
+    }
+    return NULL;
+}
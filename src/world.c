@@ -5,6 +5,7 @@
 #define _USE_MATH_DEFINES
 
 /* Standard incudes: */
+#include <stdlib.h>
 #include <math.h>
 
 /* Program includes: */